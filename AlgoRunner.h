@@ -6,17 +6,45 @@
 #define FLASHGC_ALGORUNNER_H
 
 #include "MyRand.h"
+#include "SequenceStream.h"
+#include "SkewedSequenceSource.h"
+#include "TraceSource.h"
+#include "SequenceFile.h"
 #include "FTL.hpp"
+#include "Telemetry.h"
 #include "ListItem.h"
 #include "Auxilaries.h"
 #include <map>
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <climits>
+#include <cstring>
+#include <fstream>
 #include <unistd.h>
 
 #define TBD -11
 
+/* in REAL_PAYLOAD mode every host write stamps the page with its logical page number and the host write number */
+#define PAYLOAD_STAMP_SIZE (sizeof(unsigned int) + sizeof(unsigned long long))
+#define NOT_WRITTEN 0ULL
+
+/* the adaptive steady state warmup (see WarmupOptions): by default the write amplification of a window must be
+ * within 1% of the previous window WARMUP_STABLE_WINDOWS times in a row, and the warmup stops after at most
+ * WARMUP_MAX_WINDOWS windows. a window is T erases, and at least WARMUP_MIN_WINDOW_ERASES, so that the noise of the
+ * write amplification of a window is well below the tolerance even for small memories.
+ */
+#define DEFAULT_WARMUP_TOLERANCE 0.01
+#define WARMUP_STABLE_WINDOWS 2
+#define WARMUP_MAX_WINDOWS 32
+#define WARMUP_MIN_WINDOW_ERASES 4096
+
+/* the version of the JSON run report (see AlgoRunner::writeReport). bump it when fields change meaning */
+#define REPORT_VERSION 1
+
+/* the default number of writes between two running checkpoints (see AlgoRunner::setRunCheckpoint) */
+#define DEFAULT_CHECKPOINT_INTERVAL 100000000ULL
+
 using std::map;
 using std::vector;
 
@@ -29,6 +57,22 @@ public:
     double hot_pages_probability;
 };
 
+/* how the steady state is reached: random greedy writes until the write amplification converges, or a fixed
+ * number of writes
+ */
+class WarmupOptions{
+public:
+    /* a fixed number of warmup writes, or 0 for the adaptive warmup */
+    unsigned long long writes;
+    /* adaptive only: the largest relative change of the write amplification between two windows that counts as
+     * converged, and the most writes to do (0 for at most WARMUP_MAX_WINDOWS windows)
+     */
+    double tolerance;
+    unsigned long long max_writes;
+
+    WarmupOptions() : writes(0), tolerance(DEFAULT_WARMUP_TOLERANCE), max_writes(0) {}
+};
+
 class AlgoRunner{
 public:
 
@@ -39,20 +83,33 @@ public:
     /* the writing sequence that is given as an input to all Look Ahead algorithms in this class.
      * the writing sequence is an array of integers, where writing_sequence[i] is the logical page
      * number that will be written in the ith place (i.e the i+1 write since we start from 0).
+     * the sequence is only read, so it may be shared between several AlgoRunner objects (in that case it is not
+     * owned by this object).
+     */
+    const unsigned int* writing_sequence;
+    bool owns_writing_sequence;
+
+    /* streaming mode (nullptr otherwise): the writing sequence is generated on the fly while we write it, and
+     * writing_sequence is nullptr. see SequenceStream.
      */
-    unsigned int* writing_sequence;
+    SequenceStream* stream;
 
-    /* number of pages in writing sequence. This parameter can be adjusted to be a window of known writes, but
-     * this feature may require some more adjustments
-     * In the current implementation we use the global NUMBER_OF_PAGES macro, but this is bad practice for sure
-     * if we wish to scale up in any way.. in that case we should switch and use this member element */
-    unsigned long long number_of_pages;
+    /* the memory geometry and the number of pages in the writing sequence (N) */
+    SimConfig config;
 
-    /* location list is a hash table that maps a logical page number to a ListItem that contains a list of indexes
-     * in the writing sequence such that for page i and each index j in the location list matching that page i it
-     * holds that writing_sequence[j] == i
+    /* the random state of this simulation (the writing sequence, the steady state writes and the page data) */
+    RandomGenerator rng;
+
+    /* future knowledge for the algorithms that use it (nullptr for the online algorithms): for every write in the writing
+     * sequence the location of the next write of the same page, and the closed form block score function.
+     * it is built in one backward pass over the writing sequence.
+     */
+    LookaheadScorer* scorer;
+
+    /* worker pool for generating the writing sequence and scoring blocks in parallel (nullptr when we run on a
+     * single thread)
      */
-    map<unsigned int,ListItem>* logical_pages_location_map;
+    ThreadPool* pool;
 
     /* writing page_dist represents the data distribution type - uniform distribution or Hot/Cold distribution */
     PageDistribution page_dist;
@@ -64,6 +121,12 @@ public:
      */
     UserParameters user_parameters;
 
+    /* TRACE distribution only: the trace to replay */
+    TraceOptions trace_options;
+
+    /* zipf, ycsb and tiers distributions only: their parameters */
+    SkewOptions skew_options;
+
     WindowSizeFlag window_size_flag;
 
     /* FTL memory layout object */
@@ -75,32 +138,94 @@ public:
      */
     char* data;
 
+    /* NO_PAYLOAD (default) - GC only moves page metadata.
+     * REAL_PAYLOAD - the FTL keeps the data of all pages, and we validate data integrity at the end of the run.
+     */
+    PayloadMode payload_mode;
+
+    /* REAL_PAYLOAD only: number of host writes so far, and for each logical page the host write number it was
+     * last written with (NOT_WRITTEN if it was never written)
+     */
+    unsigned long long host_writes;
+    vector<unsigned long long> expected_writes;
+
     bool reach_steady_state;
+    WarmupOptions warmup;
+
+    /* number of writes the warmup took (or the loaded checkpoint was warmed up with) */
+    unsigned long long warmup_writes;
+
+    /* steady state checkpoint files (see Checkpoint.h) to load instead of the warmup, or to save after it.
+     * nullptr if not used. checkpoint_seed is the seed of rng, which is saved with the checkpoint.
+     */
+    const char* load_steady_state;
+    const char* save_steady_state;
+    bool checkpoint_seeded;
+    unsigned long long checkpoint_seed;
+
+    /* running checkpoints (see setRunCheckpoint): the file (nullptr if not used), the number of writes between two
+     * checkpoints and the write after which the next one is saved, and whether to resume from the file.
+     */
+    const char* run_checkpoint;
+    unsigned long long checkpoint_interval;
+    unsigned long long next_checkpoint;
+    bool resume;
+
+    /* the random state the warmup started from. it identifies the writing sequence and the warmup, so a checkpoint
+     * is only loaded by a simulation that starts from the same state.
+     */
+    unsigned int initial_state[4];
+
+    /* the simulation loop parameters a running checkpoint is saved with: N, the window size, the algorithm and the
+     * number of generations. a checkpoint is only resumed by a simulation with the same parameters.
+     */
+    uint64_t run_parameters[4];
+
+    /* the time series of the simulation loop (see Telemetry.h), or nullptr */
+    Telemetry* telemetry;
+
+    /* the time of the phases of this simulation (see Profile.h). the victim selection and relocation of the FTL
+     * are only timed after setProfiling.
+     */
+    Profile profile;
+
+    /* the writes of the simulation loop done by this object (all of them unless it was resumed) */
+    unsigned long long simulated_writes;
+
     bool print_mode;
+    bool verbose;
 
     ////// C'tors & D'tor:  //////
 
     /* C'tor for scheduledGC object.
-     * NOTE: throughout the whole class implementation we use the global macros NUMBER_OF_PAGES, PAGES_PER_BLOCK, etc.
-     * I guess that best practice is not to use the global macros, and instead pass relevant parameters to the class c'tor (as we do with number_of_pages).
-     * but for now this is fine. If you were to use this class file and copy it to their your personal use,
-     * you should note that some changes may be needed to use only the parameters passed to the class
-     * c'tor (and this is better coding practice).
-     */
-    AlgoRunner(long long number_of_pages, PageDistribution page_dist, Algorithm algo, WindowSizeFlag window_size_flag) :
-                                                                        algo(algo), number_of_pages(number_of_pages), page_dist(page_dist), window_size_flag(window_size_flag), ftl(nullptr),
-                                                                        data(nullptr), reach_steady_state(true), print_mode(false){
-        /* generates writing sequence for uniform or hot-cold distribution */
-        generateWritingSequence();
+     * the simulation only depends on its parameters: config is the memory geometry and the writing sequence length,
+     * and rng is the (already seeded) random state. there is no global state, so several AlgoRunner objects can
+     * run side by side (for example on different threads).
+     * if stream_chunk is not 0 the writing sequence is streamed in chunks of stream_chunk writes instead of being
+     * generated up front (not supported by the writing assignment algorithm).
+     * for the TRACE distribution the writing sequence is replayed from trace_options, and a sequence length of 0
+     * means the whole trace.
+     * with more than one thread the writing sequence is generated and the candidate blocks are scored in parallel.
+     * the results do not depend on the number of threads.
+     * skew_options are the parameters of the zipf, ycsb and tiers distributions.
+     */
+    AlgoRunner(const SimConfig& config, const RandomGenerator& rng, PageDistribution page_dist, Algorithm algo,
+               WindowSizeFlag window_size_flag, PayloadMode payload_mode = NO_PAYLOAD, unsigned int stream_chunk = 0,
+               const TraceOptions& trace_options = TraceOptions(), int number_of_threads = 1,
+               const SkewOptions& skew_options = SkewOptions()) :
+                                                                        algo(algo), writing_sequence(nullptr), owns_writing_sequence(true), stream(nullptr), config(config), rng(rng), pool(nullptr), page_dist(page_dist), trace_options(trace_options), skew_options(skew_options), window_size_flag(window_size_flag), ftl(nullptr),
+                                                                        data(nullptr), payload_mode(payload_mode), host_writes(0), reach_steady_state(true), warmup_writes(0), load_steady_state(nullptr), save_steady_state(nullptr), checkpoint_seeded(false), checkpoint_seed(0), run_checkpoint(nullptr), checkpoint_interval(DEFAULT_CHECKPOINT_INTERVAL), next_checkpoint(ULLONG_MAX), resume(false), initial_state(), run_parameters(), telemetry(nullptr), simulated_writes(0), print_mode(false), verbose(true){
+        if (number_of_threads > 1){
+            pool = new ThreadPool(number_of_threads);
+        }
 
-        /* construct a mapping between a logical page number to a ListItem corresponding the logical page.
-        * each ListItem for logical page i contains the list of locations in the writing sequence where
-        * the page i is written. each ListItem contains a list of locations sorted in an ascending order.
-        */
+        /* generates or replays the writing sequence of the distribution */
+        generateWritingSequence(stream_chunk);
 
-        logical_pages_location_map = createLocationsMap(0,NUMBER_OF_PAGES);
         initializeFTL();
 
+        initializeScorer();
+
         /* get extra parameters:
          * window size
          * num of generations for generational algorithm
@@ -108,11 +233,42 @@ public:
         getUserParams();
     }
 
+    /* C'tor for a non interactive simulation over a given writing sequence (of config.number_of_pages writes), which
+     * is shared and not owned by this object. rng should be the random state right after the sequence was
+     * generated, so the simulation is the same as if this object generated the sequence itself.
+     * user_parameters holds the window size and the number of generations (0 for the OF heuristic). the hot/cold
+     * parameters are only used for reporting.
+     */
+    AlgoRunner(const SimConfig& config, const RandomGenerator& rng, const unsigned int* writing_sequence,
+               PageDistribution page_dist, Algorithm algo, const UserParameters& user_parameters,
+               PayloadMode payload_mode = NO_PAYLOAD) :
+            algo(algo), writing_sequence(writing_sequence), owns_writing_sequence(false), stream(nullptr), config(config),
+            rng(rng), pool(nullptr),
+            page_dist(page_dist), user_parameters(user_parameters),
+            window_size_flag(user_parameters.window_size < config.number_of_pages ? WINDOW_SIZE_ON : WINDOW_SIZE_OFF),
+            ftl(nullptr), data(nullptr), payload_mode(payload_mode), host_writes(0), reach_steady_state(true), warmup_writes(0),
+            load_steady_state(nullptr), save_steady_state(nullptr), checkpoint_seeded(false), checkpoint_seed(0),
+            run_checkpoint(nullptr), checkpoint_interval(DEFAULT_CHECKPOINT_INTERVAL), next_checkpoint(ULLONG_MAX),
+            resume(false), initial_state(), run_parameters(), telemetry(nullptr), simulated_writes(0), print_mode(false), verbose(true){
+        initializeFTL();
+
+        initializeScorer();
+
+        if (algo == GENERATIONAL && this->user_parameters.number_of_generations == 0){
+            this->user_parameters.number_of_generations = ftl->optimized_params.second;
+        }
+    }
+
     ~AlgoRunner() {
-        delete [] writing_sequence;
-        delete [] logical_pages_location_map;
+        if (owns_writing_sequence){
+            delete [] writing_sequence;
+        }
+        delete stream;
         delete [] data;
         delete ftl;
+        delete scorer;
+        delete telemetry;
+        delete pool;
     }
 
 
@@ -126,94 +282,591 @@ public:
      * data itself. for this reason we populate all pages with the same value.
      */
     void initializeFTL(){
-        ftl = new FTL();
+        if (payload_mode == REAL_PAYLOAD){
+            if (config.page_size < (int)PAYLOAD_STAMP_SIZE){
+                cerr<<"Error! Page size must be at least "<<PAYLOAD_STAMP_SIZE<<" bytes to validate the page payload."<<endl;
+                exit(-1);
+            }
+            expected_writes.assign(config.logicalPages(), NOT_WRITTEN);
+        }
+        ftl = new FTL(config, payload_mode);
 
         /* initialize data page. will remain the same */
-        data = new char[PAGE_SIZE];
+        data = new char[config.page_size];
 
        /* fill pages with random data */
-        for (int j = 0; j < PAGE_SIZE; j++) {
-            data[j] = KISS() % 256;
+        for (int j = 0; j < config.page_size; j++) {
+            data[j] = rng.KISS() % 256;
+        }
+    }
+
+    /* for each write in the writing sequence, find the location of the next write of the same page */
+    void initializeScorer(){
+        scorer = nullptr;
+        if (!isOnlineAlgorithm(algo)){
+            if (stream){
+                scorer = new LookaheadScorer(config.number_of_pages, config.logicalPages(), config.physicalPages(),
+                                             ftl->optimized_params.first, stream->capacity());
+                stream->setScorer(scorer);
+            }
+            else {
+                ScopedTimer timer(&profile, SCORER_PHASE);
+                scorer = new LookaheadScorer(writing_sequence, config.number_of_pages, config.logicalPages(),
+                                             config.physicalPages(), ftl->optimized_params.first);
+            }
+            ftl->scorer = scorer;
         }
+        ftl->pool = pool;
     }
 
     void setSteadyState(bool state){
         reach_steady_state = state;
     }
 
+    void setWarmup(const WarmupOptions& options){
+        warmup = options;
+    }
+
+    unsigned long long getWarmupWrites() const{
+        return warmup_writes;
+    }
+
+    /* load the steady state from load_path instead of warming up, and/or save it to save_path after the warmup
+     * (either may be nullptr). seed is the seed rng was created with (if seeded), and is only recorded.
+     */
+    void setSteadyStateCheckpoint(const char* load_path, const char* save_path, bool seeded, unsigned long long seed){
+        load_steady_state = load_path;
+        save_steady_state = save_path;
+        checkpoint_seeded = seeded;
+        checkpoint_seed = seed;
+    }
+
+    /* save a running checkpoint to path every interval writes of the simulation (path may be nullptr), and if
+     * resume is set and path exists, go on from the checkpoint in it instead of starting over. the results are the
+     * same as if the simulation was never stopped. the checkpoint must have been saved by a simulation with the same
+     * parameters and random state.
+     */
+    void setRunCheckpoint(const char* path, unsigned long long interval, bool resume){
+        run_checkpoint = path;
+        checkpoint_interval = interval ? interval : DEFAULT_CHECKPOINT_INTERVAL;
+        this->resume = resume;
+    }
+
+    /* record the time series of the simulation loop to options.path (see Telemetry.h) */
+    void setTelemetry(const TelemetryOptions& options){
+        delete telemetry;
+        telemetry = options.path ? new Telemetry(config, options) : nullptr;
+    }
+
+    /* time the victim selection and the relocation of every erase, and count the block scores (see Profile.h) */
+    void setProfiling(bool mode){
+        ftl->profile = mode ? &profile : nullptr;
+    }
+
     void setPrintMode(bool mode){
         print_mode = mode;
         ftl->print_mode = mode;
     }
 
+    /* when turned off, the simulation doesn't print its progress (used when many simulations run at once) */
+    void setVerbose(bool mode){
+        verbose = mode;
+    }
+
+    /* set the look ahead victim selection (see FTL::candidate_buckets and FTL::candidate_budget) */
+    void setCandidateSelection(int candidate_buckets, int candidate_budget){
+        ftl->candidate_buckets = candidate_buckets;
+        ftl->candidate_budget = candidate_budget;
+    }
+
+    /* streaming mode only: generate the writing sequence on a separate thread while we simulate it. the results
+     * are the same as without the pipeline. must be called before the simulation starts.
+     */
+    void setPipelined(){
+        if (stream){
+            stream->startPipeline();
+        }
+    }
+
+    /* write the writing sequence to a sequence file (see SequenceFile.h) instead of simulating it, so it can be
+     * replayed later with the trace distribution and --trace-format=binary. seed is the seed rng was created with.
+     * returns the size of the file.
+     */
+    unsigned long long recordWritingSequence(const char* path, unsigned long long seed){
+        SequenceFileHeader header(config, page_dist);
+        if (page_dist != TRACE){
+            header.seed = seed;
+            header.flags |= SEQUENCE_FILE_HAS_SEED;
+        }
+        if (page_dist == HOT_COLD){
+            header.hot_pages_percentage = user_parameters.hot_pages_percentage;
+            header.hot_pages_probability = user_parameters.hot_pages_probability;
+        }
+        SequenceFileWriter writer(path, header);
+        vector<unsigned int> chunk(DEFAULT_SEQUENCE_BLOCK);
+        for (unsigned long long i = 0; i < config.number_of_pages; i += chunk.size()){
+            unsigned long long count = min((unsigned long long)chunk.size(), config.number_of_pages - i);
+            for (unsigned long long j = 0; j < count; j++){
+                chunk[j] = pageAt(i + j);
+            }
+            writer.append(chunk.data(), count);
+        }
+        return writer.close();
+    }
+
+    /* the logical page number of the index-th write of the writing sequence. in streaming mode the writes must be
+     * read in order.
+     */
+    unsigned int pageAt(unsigned long long index){
+        if (stream){
+            return stream->at(index);
+        }
+        return writing_sequence[index];
+    }
+
+    /* get the data to write for a host write of logical page lpn. in REAL_PAYLOAD mode the page is stamped
+     * so we can later verify that GC relocated the data along with the page.
+     */
+    char* pageData(unsigned int lpn){
+        if (payload_mode == REAL_PAYLOAD){
+            host_writes++;
+            memcpy(data, &lpn, sizeof(lpn));
+            memcpy(data + sizeof(lpn), &host_writes, sizeof(host_writes));
+            expected_writes[lpn] = host_writes;
+        }
+        return data;
+    }
+
+    /* REAL_PAYLOAD only: read back every logical page that was written and check its stamp.
+     * returns the number of corrupted pages.
+     */
+    unsigned long long verifyDataIntegrity() const{
+        unsigned long long corrupted = 0;
+        vector<char> buffer(config.page_size);
+        for (unsigned int lpn = 0; lpn < expected_writes.size(); lpn++) {
+            if (expected_writes[lpn] == NOT_WRITTEN){
+                continue;
+            }
+            unsigned int stamped_lpn;
+            unsigned long long stamped_write;
+            ftl->read(buffer.data(), lpn);
+            memcpy(&stamped_lpn, buffer.data(), sizeof(stamped_lpn));
+            memcpy(&stamped_write, buffer.data() + sizeof(stamped_lpn), sizeof(stamped_write));
+            if (stamped_lpn != lpn || stamped_write != expected_writes[lpn]){
+                corrupted++;
+            }
+        }
+        return corrupted;
+    }
+
     void reachSteadyState(){
-        unsigned int logical_page_to_write;
-        data = new char[PAGE_SIZE];
+        ScopedTimer timer(&profile, WARMUP_PHASE);
+        rng.getState(initial_state);
+        if (load_steady_state){
+            loadSteadyState();
+            return;
+        }
 
         /* fill pages with random data */
-        for (int j = 0; j < PAGE_SIZE; j++) {
-            data[j] = KISS() % 256;
+        for (int j = 0; j < config.page_size; j++) {
+            data[j] = rng.KISS() % 256;
         }
 
         /* reach steady state */
-        cout<<"Reaching Steady State..."<<endl;
+        if (verbose){
+            cout<<"Reaching Steady State..."<<endl;
+        }
         if (print_mode){
             ftl->printHeader();
         }
-        /* you can adjust this */
-        for (int i = 0; i < 1000000; i++) {
-            logical_page_to_write = KISS() % (LOGICAL_BLOCK_NUMBER * PAGES_PER_BLOCK);
-            ftl->write(data,logical_page_to_write,GREEDY);
+        if (warmup.writes){
+            for (unsigned long long i = 0; i < warmup.writes; i++) {
+                warmupWrite();
+            }
+            warmup_writes = warmup.writes;
+        }
+        else {
+            warmup_writes = warmUpUntilConverged();
         }
         ftl->erases_steady = ftl->erases;
         ftl->logicalPageWritesSteady = ftl->logicalPageWrites;
         ftl->physicalPageWritesSteady = ftl->physicalPageWrites;
-        cout<<"Steady State Reached..."<<endl;
-        cout << endl;
+        if (save_steady_state){
+            saveSteadyState();
+        }
+        if (verbose){
+            cout<<"Steady State Reached after "<<warmup_writes<<" writes..."<<endl;
+            cout << endl;
+        }
+    }
+
+    /* one random greedy write of the warmup */
+    void warmupWrite(){
+        unsigned int logical_page_to_write = rng.uniform(config.logicalPages());
+        ftl->write(pageData(logical_page_to_write),logical_page_to_write,GREEDY);
+    }
+
+    /* fill the logical space once, and then go on in windows of erases until the write amplification of a window
+     * is within the tolerance of the previous window WARMUP_STABLE_WINDOWS times in a row (or the cap is hit).
+     * returns the number of writes.
+     */
+    unsigned long long warmUpUntilConverged(){
+        unsigned long long max_writes = warmup.max_writes ? warmup.max_writes : ULLONG_MAX;
+        long long window_erases = std::max(config.physical_blocks, WARMUP_MIN_WINDOW_ERASES);
+        unsigned long long writes = 0;
+        for (; writes < config.logicalPages() && writes < max_writes; writes++){
+            warmupWrite();
+        }
+
+        long long window_start_erases = ftl->erases;
+        long long window_start_logical = ftl->logicalPageWrites;
+        long long window_start_physical = ftl->physicalPageWrites;
+        double last_write_amplification = 0;
+        int stable_windows = 0;
+        int windows = 0;
+        bool converged = false;
+        while (writes < max_writes && windows < WARMUP_MAX_WINDOWS){
+            warmupWrite();
+            writes++;
+            if (ftl->erases - window_start_erases < window_erases){
+                continue;
+            }
+            double write_amplification = (double)(ftl->physicalPageWrites - window_start_physical) /
+                                         (ftl->logicalPageWrites - window_start_logical);
+            if (last_write_amplification > 0 &&
+                fabs(write_amplification - last_write_amplification) <= warmup.tolerance * last_write_amplification){
+                stable_windows++;
+            }
+            else {
+                stable_windows = 0;
+            }
+            windows++;
+            if (stable_windows == WARMUP_STABLE_WINDOWS){
+                converged = true;
+                break;
+            }
+            last_write_amplification = write_amplification;
+            window_start_erases = ftl->erases;
+            window_start_logical = ftl->logicalPageWrites;
+            window_start_physical = ftl->physicalPageWrites;
+        }
+        if (!converged && verbose){
+            cout<<"The write amplification did not converge within "<<writes<<" warmup writes."<<endl;
+        }
+        return writes;
+    }
+
+    /* the header of a checkpoint of this simulation */
+    CheckpointHeader checkpointHeader(uint32_t flags) const{
+        CheckpointHeader header(config);
+        memcpy(header.random_state, initial_state, sizeof(header.random_state));
+        header.warmup_writes = warmup_writes;
+        header.flags = flags;
+        if (checkpoint_seeded){
+            header.flags |= CHECKPOINT_HAS_SEED;
+            header.seed = checkpoint_seed;
+        }
+        if (payload_mode == REAL_PAYLOAD){
+            header.flags |= CHECKPOINT_REAL_PAYLOAD;
+        }
+        return header;
+    }
+
+    /* write the state of the simulation: rng, the page data, (REAL_PAYLOAD) the expected stamps and the FTL */
+    void writeState(CheckpointWriter* writer) const{
+        unsigned int state[4];
+        rng.getState(state);
+        writer->write(state, sizeof(state));
+        writer->write(data, config.page_size);
+        writer->writeValue<uint64_t>(host_writes);
+        if (payload_mode == REAL_PAYLOAD){
+            writer->write(expected_writes.data(), sizeof(unsigned long long) * expected_writes.size());
+        }
+        ftl->saveState(writer);
+    }
+
+    /* read the state written by writeState */
+    void readState(CheckpointReader* reader){
+        unsigned int state[4];
+        reader->read(state, sizeof(state));
+        rng.setState(state);
+        reader->read(data, config.page_size);
+        host_writes = reader->readValue<uint64_t>();
+        if (payload_mode == REAL_PAYLOAD){
+            reader->read(expected_writes.data(), sizeof(unsigned long long) * expected_writes.size());
+        }
+        ftl->loadState(reader);
+        reader->finish();
+        warmup_writes = reader->header().warmup_writes;
+    }
+
+    /* check that the checkpoint in path was saved from the same geometry, payload mode and random state (and is
+     * a running checkpoint if running is set), so the simulation goes on exactly as if it was never stopped
+     */
+    void checkCheckpoint(const char* path, const CheckpointHeader& header, bool running) const{
+        if (!header.sameGeometry(config)){
+            cerr << "Error! Checkpoint file " << path << " was saved with T=" << header.physical_blocks
+                 << " U=" << header.logical_blocks << " Z=" << header.pages_per_block << " page size "
+                 << header.page_size << "." << endl;
+            exit(-1);
+        }
+        if (((header.flags & CHECKPOINT_REAL_PAYLOAD) != 0) != (payload_mode == REAL_PAYLOAD)){
+            cerr << "Error! Checkpoint file " << path << " was saved with another payload mode." << endl;
+            exit(-1);
+        }
+        if (((header.flags & CHECKPOINT_RUNNING) != 0) != running){
+            cerr << "Error! Checkpoint file " << path << (running ? " is a steady state checkpoint. Use --load-steady-state to load it."
+                                                               : " was saved during a simulation. Use --resume to go on from it.") << endl;
+            exit(-1);
+        }
+        if (memcmp(header.random_state, initial_state, sizeof(header.random_state)) != 0){
+            cerr << "Error! Checkpoint file " << path << " was saved from another random state";
+            if (header.flags & CHECKPOINT_HAS_SEED){
+                cerr << " (seed " << header.seed << ")";
+            }
+            cerr << ". Use the same seed and distribution it was saved with." << endl;
+            exit(-1);
+        }
+    }
+
+    /* save the state after the warmup */
+    void saveSteadyState(){
+        CheckpointWriter writer(save_steady_state, checkpointHeader(0));
+        writeState(&writer);
+        unsigned long long file_size = writer.close();
+        if (verbose){
+            cout << "Saved the steady state to " << save_steady_state << " (" << file_size << " bytes)." << endl;
+        }
+    }
+
+    /* load the state saved by saveSteadyState */
+    void loadSteadyState(){
+        CheckpointReader reader(load_steady_state);
+        checkCheckpoint(load_steady_state, reader.header(), false);
+        readState(&reader);
+        if (verbose){
+            cout << "Loaded the steady state from " << load_steady_state << " (" << warmup_writes
+                 << " warmup writes)." << endl;
+            cout << endl;
+        }
+    }
+
+    /* bring the simulation to the write the simulation loop starts from: reach the steady state, or (when resuming)
+     * load the state of the running checkpoint. window_size and num_of_gens are the parameters of the loop.
+     * returns the index of the first write to do.
+     */
+    unsigned long long startRun(unsigned long long window_size, int num_of_gens){
+        run_parameters[0] = config.number_of_pages;
+        run_parameters[1] = window_size;
+        run_parameters[2] = algo;
+        run_parameters[3] = num_of_gens;
+        rng.getState(initial_state);
+        unsigned long long first_write = 0;
+        if (resume && run_checkpoint && access(run_checkpoint, F_OK) == 0){
+            first_write = resumeRun();
+        }
+        else {
+            if (resume && run_checkpoint && verbose){
+                cout << "No checkpoint to resume from in " << run_checkpoint << ", starting a new simulation." << endl;
+            }
+            if (reach_steady_state){
+                reachSteadyState();
+            }
+        }
+        if (run_checkpoint){
+            next_checkpoint = (first_write / checkpoint_interval + 1) * checkpoint_interval;
+        }
+        if (telemetry){
+            telemetry->sample(ftl, first_write);
+        }
+        simulated_writes = config.number_of_pages - first_write;
+        return first_write;
+    }
+
+    /* the simulation loop is done: take the last telemetry sample and write the rest of the samples */
+    void finishRun(){
+        if (telemetry){
+            telemetry->sample(ftl, config.number_of_pages);
+            telemetry->close();
+        }
+    }
+
+    /* load the running checkpoint, and skip the writes that were done before it was saved. returns the next write */
+    unsigned long long resumeRun(){
+        CheckpointReader reader(run_checkpoint);
+        checkCheckpoint(run_checkpoint, reader.header(), true);
+        unsigned long long first_write = reader.readValue<uint64_t>();
+        uint64_t parameters[4];
+        reader.read(parameters, sizeof(parameters));
+        if (memcmp(parameters, run_parameters, sizeof(parameters)) != 0){
+            cerr << "Error! Checkpoint file " << run_checkpoint << " was saved by a simulation with N=" << parameters[0]
+                 << ", window size " << parameters[1] << ", another algorithm or another number of generations."
+                 << endl;
+            exit(-1);
+        }
+        if (first_write > config.number_of_pages){
+            reader.corrupted();
+        }
+        readState(&reader);
+
+        /* the scorer must know the next write of every page from first_write on */
+        if (stream){
+            stream->skipTo(first_write);
+        }
+        else if (scorer){
+            for (unsigned long long i = 0; i < first_write; i++){
+                scorer->onHostWrite(writing_sequence[i], i);
+            }
+        }
+        if (verbose){
+            cout << "Resumed from " << run_checkpoint << " at write " << first_write << " of "
+                 << config.number_of_pages << " (" << warmup_writes << " warmup writes)." << endl;
+            cout << endl;
+        }
+        return first_write;
+    }
+
+    /* called after every write of the simulation loop: take the telemetry samples and save the running checkpoints
+     * that are due. next_write is the index of the next write to do.
+     */
+    void afterWrite(unsigned long long next_write){
+        if (telemetry && telemetry->due(next_write, ftl->erases)){
+            telemetry->sample(ftl, next_write);
+        }
+        if (next_write == next_checkpoint){
+            saveRunCheckpoint(next_write);
+        }
+    }
+
+    /* save a running checkpoint, and set the write of the next one */
+    void saveRunCheckpoint(unsigned long long next_write){
+        ScopedTimer timer(&profile, CHECKPOINT_PHASE);
+        next_checkpoint += checkpoint_interval;
+        CheckpointWriter writer(run_checkpoint, checkpointHeader(CHECKPOINT_RUNNING));
+        writer.writeValue<uint64_t>(next_write);
+        writer.write(run_parameters, sizeof(run_parameters));
+        writeState(&writer);
+        writer.close();
     }
 
     /* get the number of unique logical pages in writing_sequence */
     unsigned int getLocationListSize(unsigned long long base_index, unsigned int window_size) const{
         set<int> logical_pages_in_window;
-        for (unsigned long long i = base_index; i < base_index + window_size && i < NUMBER_OF_PAGES ; ++i) {
+        for (unsigned long long i = base_index; i < base_index + window_size && i < config.number_of_pages ; ++i) {
             logical_pages_in_window.insert(writing_sequence[i]); // will not add duplicates
         }
         return logical_pages_in_window.size();
     }
 
-    void generateWritingSequence(){
+    /* the generated sequences only take a key from rng (see GeneratedSequenceSource), so a streamed sequence and
+     * the random state of the rest of the simulation are the same as in memory
+     */
+    void generateWritingSequence(unsigned int stream_chunk = 0){
         /* generate a writing sequence according to the desired writing page_dist */
-        if (page_dist == UNIFORM){
-            writing_sequence = generateUniformlyDistributedWriteSequence();
+        if (page_dist == TRACE){
+            SequenceSource* source;
+            unsigned long long trace_length;
+            if (trace_options.format == BINARY_TRACE){
+                SequenceFileSource* file = new SequenceFileSource(config, trace_options.path);
+                trace_length = file->header().number_of_pages;
+                source = file;
+            }
+            else {
+                TraceSequenceSource* trace = new TraceSequenceSource(config, trace_options);
+                trace_length = config.number_of_pages == 0 ? trace->countPageWrites() : 0;
+                source = trace;
+            }
+            if (config.number_of_pages == 0){
+                config.number_of_pages = trace_length;
+                if (verbose){
+                    cout << "Replaying the whole trace: " << config.number_of_pages << " page writes." << endl;
+                }
+            }
+            if (stream_chunk){
+                streamWritingSequence(source, stream_chunk);
+            }
+            else {
+                ScopedTimer timer(&profile, SEQUENCE_PHASE);
+                unsigned int* sequence = new unsigned int[config.number_of_pages];
+                source->fill(sequence, config.number_of_pages);
+                writing_sequence = sequence;
+                delete source;
+            }
         }
         else {
-            if(output_file){
-                dup2(fd_stdout, 1);
+            if (page_dist == HOT_COLD){
+                getHotColdParamsFromUser();
             }
-            cout<<"Please enter parameters for Hot/Cold memory simulation."<<endl<<"Enter the hot page percentage out of all logical pages in memory (0-100): "<<endl;
-            cin >> user_parameters.hot_pages_percentage;
-            if(user_parameters.hot_pages_percentage < 0 or user_parameters.hot_pages_percentage > 100){
-                cerr<<"Error! Hot pages percentage must be in 0-100 range. Use --help for more information."<<endl;
-                exit(-1);
+            GeneratedSequenceSource* source = newGeneratedSequenceSource();
+            if (stream_chunk){
+                streamWritingSequence(source, stream_chunk);
             }
-            cout<<"Enter the probability for hot pages (0-1): "<<endl;
-            cin >> user_parameters.hot_pages_probability;
-            if(user_parameters.hot_pages_probability < 0 or user_parameters.hot_pages_probability > 1){
-                cerr<<"Error! Hot pages probability must be in 0-1 range. Use --help for more information."<<endl;
-                exit(-1);
+            else {
+                ScopedTimer timer(&profile, SEQUENCE_PHASE);
+                writing_sequence = generateWriteSequence(config, *source, pool);
+                delete source;
             }
-            if(output_file)
-                freopen(output_file, "a", stdout);
-            writing_sequence = generateHotColdWriteSequence(user_parameters.hot_pages_percentage, user_parameters.hot_pages_probability);
         }
     }
 
+    /* the source of a generated (not replayed) writing sequence */
+    GeneratedSequenceSource* newGeneratedSequenceSource(){
+        switch (page_dist){
+            case HOT_COLD:
+                return new HotColdSequenceSource(config, &rng, user_parameters.hot_pages_percentage,
+                                                 user_parameters.hot_pages_probability);
+            case ZIPF:
+                return new ZipfSequenceSource(config, &rng, skew_options.zipf_theta, false);
+            case YCSB:
+                return new ZipfSequenceSource(config, &rng, skew_options.zipf_theta, true);
+            case TIERED:
+                return new TieredSequenceSource(config, &rng, skew_options.tiers);
+            case TPCC:
+                return new NURandSequenceSource(config, &rng);
+            default:
+                return new UniformSequenceSource(config, &rng);
+        }
+    }
+
+    void getHotColdParamsFromUser(){
+        if(output_file){
+            dup2(fd_stdout, 1);
+        }
+        cout<<"Please enter parameters for Hot/Cold memory simulation."<<endl<<"Enter the hot page percentage out of all logical pages in memory (0-100): "<<endl;
+        cin >> user_parameters.hot_pages_percentage;
+        if(user_parameters.hot_pages_percentage < 0 or user_parameters.hot_pages_percentage > 100){
+            cerr<<"Error! Hot pages percentage must be in 0-100 range. Use --help for more information."<<endl;
+            exit(-1);
+        }
+        cout<<"Enter the probability for hot pages (0-1): "<<endl;
+        cin >> user_parameters.hot_pages_probability;
+        if(user_parameters.hot_pages_probability < 0 or user_parameters.hot_pages_probability > 1){
+            cerr<<"Error! Hot pages probability must be in 0-1 range. Use --help for more information."<<endl;
+            exit(-1);
+        }
+        if(output_file)
+            freopen(output_file, "a", stdout);
+    }
+
+    /* the block score scans Z*T writes ahead, and the generational algorithm only looks at most U*Z writes ahead
+     * for the page score, so this is the horizon of every algorithm that has future knowledge. the online
+     * algorithms don't look ahead.
+     */
+    void streamWritingSequence(SequenceSource* source, unsigned int chunk_size){
+        unsigned long long horizon = 0;
+        if (!isOnlineAlgorithm(algo)){
+            horizon = min(config.physicalPages(), config.number_of_pages);
+        }
+        stream = new SequenceStream(source, config.number_of_pages, horizon, chunk_size);
+        stream->setProfile(&profile);
+    }
+
     void getUserParams(){
-        if(algo != GREEDY) {
+        if(!isOnlineAlgorithm(algo)) {
             if (window_size_flag == WINDOW_SIZE_ON)
                 getWindowSizeFromUser();
             if (window_size_flag == WINDOW_SIZE_OFF)
-                user_parameters.window_size = NUMBER_OF_PAGES;
+                user_parameters.window_size = config.number_of_pages;
         }
         if(algo == GENERATIONAL)
             getNumOfGenerationsFromUser();
@@ -222,7 +875,7 @@ public:
     map<unsigned int,ListItem>* createLocationsMap(unsigned long long base_index, unsigned int window_size) const{
         unsigned int location_list_size = getLocationListSize(base_index,window_size);
         map<unsigned int,ListItem>* locations_list = new map<unsigned int,ListItem>[location_list_size];
-        for (unsigned long long i = base_index; i < base_index + window_size && i < NUMBER_OF_PAGES; ++i) {
+        for (unsigned long long i = base_index; i < base_index + window_size && i < config.number_of_pages; ++i) {
             auto iterator = locations_list->find(writing_sequence[i]);
             if (iterator == locations_list->end()){
                 locations_list->insert({writing_sequence[i],ListItem(writing_sequence[i],i)});
@@ -235,63 +888,153 @@ public:
     }
 
     void runGreedySimulation(Algorithm algo, unsigned long long window_size = 0) {
-        if (reach_steady_state){
-            reachSteadyState();
-        }
-        for (unsigned long long i = 0; i < window_size; i++) {
-            ftl->write(data,writing_sequence[i], algo, writing_sequence, i);
+        unsigned long long first_write = startRun(window_size, 0);
+        ScopedTimer timer(&profile, SIMULATION_PHASE);
+        for (unsigned long long i = first_write; i < window_size; i++) {
+            unsigned int lpn = pageAt(i);
+            ftl->write(pageData(lpn),lpn, algo, writing_sequence, i);
+            afterWrite(i + 1);
         }
         /* After running LOOK_AHEAD/GENERATIONAL algorithm, now we should run
          * GREEDY for the rest of writing sequence */
-        for (unsigned long long i = window_size; i < NUMBER_OF_PAGES; i++) {
-            ftl->write(data,writing_sequence[i],GREEDY, writing_sequence, i);
+        for (unsigned long long i = max(window_size, first_write); i < config.number_of_pages; i++) {
+            unsigned int lpn = pageAt(i);
+            ftl->write(pageData(lpn),lpn,GREEDY, writing_sequence, i);
+            afterWrite(i + 1);
         }
+        finishRun();
     }
 
     void runSimulation(Algorithm algorithm){
         switch (algorithm) {
             case GREEDY:
-                cout<<"Starting Greedy Algorithm simulation..."<<endl;
+                if (verbose)
+                    cout<<"Starting Greedy Algorithm simulation..."<<endl;
                 runGreedySimulation(GREEDY);
                 break;
             case GREEDY_LOOKAHEAD:
-                cout<<"Starting Greedy LookAhead Algorithm simulation..."<<endl;
+                if (verbose)
+                    cout<<"Starting Greedy LookAhead Algorithm simulation..."<<endl;
                 runGreedySimulation(GREEDY_LOOKAHEAD, user_parameters.window_size);
                 break;
             case GENERATIONAL:
-                cout<<"Starting Generational Algorithm simulation..."<<endl;
+                if (verbose)
+                    cout<<"Starting Generational Algorithm simulation..."<<endl;
                 runGenerationalSimulation(user_parameters.number_of_generations, user_parameters.window_size);
                 break;
             case WRITING_ASSIGNMENT:
-                cout<<"Starting Writing Assignment Algorithm simulation..."<<endl;
+                if (verbose)
+                    cout<<"Starting Writing Assignment Algorithm simulation..."<<endl;
                 runWritingAssignmentSimulation();
                 break;
+            case COST_BENEFIT:
+                if (verbose)
+                    cout<<"Starting Cost-Benefit Algorithm simulation..."<<endl;
+                runGreedySimulation(COST_BENEFIT, config.number_of_pages);
+                break;
+            case COST_AGE_TIMES:
+                if (verbose)
+                    cout<<"Starting Cost-Age-Times Algorithm simulation..."<<endl;
+                runGreedySimulation(COST_AGE_TIMES, config.number_of_pages);
+                break;
             default:
                 cerr<<"Error in runSimulation"<<endl;
                 exit(1);
         }
     }
 
+    /* number of block erases since steady state */
+    long long getErases() const{
+        return ftl->erases-ftl->erases_steady;
+    }
+
+    /* write amplification since steady state */
+    double getWriteAmplification() const{
+        long long logical_page_writes = ftl->logicalPageWrites-ftl->logicalPageWritesSteady;
+        long long physical_page_writes = ftl->physicalPageWrites-ftl->physicalPageWritesSteady;
+        return (double)physical_page_writes/logical_page_writes;
+    }
+
     void printSimulationResults() const{
-        int erases = ftl->erases-ftl->erases_steady;
-        int logical_page_writes = ftl->logicalPageWrites-ftl->logicalPageWritesSteady;
-        int physical_page_writes = ftl->physicalPageWrites-ftl->physicalPageWritesSteady;
-        double wa = (double)physical_page_writes/logical_page_writes;
-        //double erasure_factor = erases/(NUMBER_OF_PAGES /(double)PAGES_PER_BLOCK);
-        cout << "Simulation Results:" << endl << "Number of erases: " << erases
-        << ". Write Amplification: " << wa << endl;
+        //double erasure_factor = erases/(config.number_of_pages /(double)config.pages_per_block);
+        cout << "Simulation Results:" << endl << "Number of erases: " << getErases()
+        << ". Write Amplification: " << getWriteAmplification() << endl;
+        if (payload_mode == REAL_PAYLOAD){
+            unsigned long long corrupted = verifyDataIntegrity();
+            if (corrupted == 0){
+                cout << "Data integrity check passed." << endl;
+            }
+            else {
+                cout << "Data integrity check failed! " << corrupted << " corrupted pages." << endl;
+            }
+        }
+    }
+
+    /* write a JSON report of the run to path: the parameters, the results, the time of every phase and the victim
+     * selection counters. distribution and algorithm are the names they were given with, and seed is the seed rng
+     * was created with. it is written after the simulation, for regression tracking across versions.
+     */
+    void writeReport(const char* path, const char* distribution, const char* algorithm, unsigned long long seed) const{
+        std::ofstream out(path);
+        if (!out){
+            cerr << "Error! Could not create report file " << path << "." << endl;
+            exit(-1);
+        }
+        double simulation_seconds = profile.seconds(SIMULATION_PHASE);
+        double write_amplification = getWriteAmplification();
+        out.precision(10);
+        out << "{" << endl;
+        out << "  \"report_version\": " << REPORT_VERSION << "," << endl;
+        out << "  \"geometry\": {\"T\": " << config.physical_blocks << ", \"U\": " << config.logical_blocks
+            << ", \"Z\": " << config.pages_per_block << ", \"page_size\": " << config.page_size << ", \"N\": "
+            << config.number_of_pages << "}," << endl;
+        out << "  \"distribution\": \"" << distribution << "\"," << endl;
+        out << "  \"algorithm\": \"" << algorithm << "\"," << endl;
+        out << "  \"seed\": " << seed << "," << endl;
+        out << "  \"threads\": " << (pool ? pool->size() : 1) << "," << endl;
+        out << "  \"streamed\": " << (stream ? "true" : "false") << "," << endl;
+        out << "  \"warmup_writes\": " << warmup_writes << "," << endl;
+        out << "  \"erases\": " << getErases() << "," << endl;
+        out << "  \"write_amplification\": ";
+        if (std::isfinite(write_amplification)){
+            out << write_amplification;
+        }
+        else {
+            out << "null";
+        }
+        out << "," << endl;
+        out << "  \"simulated_writes\": " << simulated_writes << "," << endl;
+        out << "  \"writes_per_second\": " << (simulation_seconds > 0 ? simulated_writes / simulation_seconds : 0)
+            << "," << endl;
+        out << "  \"phases\": {" << endl;
+        for (int phase = 0; phase < NUMBER_OF_PHASES; phase++){
+            out << "    \"" << phaseEnumToString((Phase)phase) << "\": {\"seconds\": " << profile.seconds((Phase)phase)
+                << ", \"calls\": " << profile.phase_calls[phase] << "}" << (phase + 1 < NUMBER_OF_PHASES ? "," : "")
+                << endl;
+        }
+        out << "  }," << endl;
+        out << "  \"blocks_scored\": " << profile.blocks_scored.load() << "," << endl;
+        out << "  \"pages_scanned\": " << profile.pages_scanned.load() << endl;
+        out << "}" << endl;
+        if (!out){
+            cerr << "Error! Could not write report file " << path << "." << endl;
+            exit(-1);
+        }
     }
 
     void runWritingAssignmentSimulation(){
         if (reach_steady_state){
             reachSteadyState();
         }
+        ScopedTimer timer(&profile, SIMULATION_PHASE);
+        simulated_writes = config.number_of_pages;
         unsigned long long base_index = 0;
         unsigned int window_size = getWindowSize();
-        while (base_index < NUMBER_OF_PAGES){
+        while (base_index < config.number_of_pages){
             vector<pair<unsigned int,int>> writing_assignment = getWritingAssignment(base_index,window_size);
-            for (unsigned long long i = 0; i < writing_assignment.size() && i < NUMBER_OF_PAGES; i++) {
-                ftl->writeToBlock(data, writing_assignment[i].first, writing_assignment[i].second);
+            for (unsigned long long i = 0; i < writing_assignment.size() && i < config.number_of_pages; i++) {
+                ftl->writeToBlock(pageData(writing_assignment[i].first), writing_assignment[i].first, writing_assignment[i].second,
+                                  writing_sequence, base_index + i);
             }
             base_index += window_size;
             window_size = getWindowSize();
@@ -300,9 +1043,9 @@ public:
 
     unsigned int getWindowSize() const{
         if (page_dist == UNIFORM){
-            return (PHYSICAL_BLOCK_NUMBER * PAGES_PER_BLOCK) - ftl->windowSizeAux();
+            return config.physicalPages() - ftl->windowSizeAux();
         }
-        return (PHYSICAL_BLOCK_NUMBER * PAGES_PER_BLOCK) - ftl->getNumberOfValidPages();
+        return config.physicalPages() - ftl->getNumberOfValidPages();
     }
 
     void getWindowSizeFromUser(){
@@ -311,7 +1054,7 @@ public:
         }
         cout << "Enter Window Size:"<<endl;
         cin >> user_parameters.window_size;
-        if(user_parameters.window_size > NUMBER_OF_PAGES){
+        if(user_parameters.window_size > config.number_of_pages){
             cerr<<"Error! Window size is bigger than Number Of Pages."<<endl;
             printHelp();
             exit(-1);
@@ -330,7 +1073,7 @@ public:
         cin >> user_parameters.number_of_generations;
         if(output_file)
             freopen(output_file, "a", stdout);
-        if (user_parameters.number_of_generations > PHYSICAL_BLOCK_NUMBER - LOGICAL_BLOCK_NUMBER){
+        if (user_parameters.number_of_generations > config.physical_blocks - config.logical_blocks){
             cerr << "Error! number of generations must be at least T-U. Use --help for more information." << endl;
             exit(-1);
         }
@@ -360,14 +1103,15 @@ public:
         ftl->printMemoryLayout();
         unsigned long long base_index = 0;
         unsigned int window_size = getWindowSize();
-        while (base_index < NUMBER_OF_PAGES){
+        while (base_index < config.number_of_pages){
             cout<<"memory before window writes:"<<endl;
             ftl->printMemoryLayout();
             cout<<"window size: "<<window_size<<endl;
             vector<pair<unsigned int,int>> writing_assignment = getWritingAssignment(base_index,window_size);
             printAssignment(writing_assignment);
-            for (unsigned long long i = 0; i < writing_assignment.size() && i < NUMBER_OF_PAGES; i++) {
-                ftl->writeToBlock(data, writing_assignment[i].first, writing_assignment[i].second);
+            for (unsigned long long i = 0; i < writing_assignment.size() && i < config.number_of_pages; i++) {
+                ftl->writeToBlock(pageData(writing_assignment[i].first), writing_assignment[i].first, writing_assignment[i].second,
+                                  writing_sequence, base_index + i);
             }
             cout<<"memory after window writes:"<<endl;
             ftl->printMemoryLayout();
@@ -387,7 +1131,7 @@ public:
         /* construct a result vector, containing pairs of (logical_page_to_write,physical_block_to_write_to) */
         vector<pair<unsigned int,int>> res(window_size);
         int j = 0;
-        for (unsigned long long i = base_index; i < base_index + window_size && i < NUMBER_OF_PAGES ; i++){
+        for (unsigned long long i = base_index; i < base_index + window_size && i < config.number_of_pages ; i++){
             res[j].first = writing_sequence[i];
             res[j].second = TBD;
             j++;
@@ -397,12 +1141,16 @@ public:
          * each ListItem for logical page i contains the list of locations in the writing sequence where
          * the page i is written. each ListItem should contain a list of locations sorted in an ascending order.
          */
-        map<unsigned int,ListItem>* locations_list = createLocationsMap(base_index, window_size);
+        map<unsigned int,ListItem>* locations_list;
+        {
+            ScopedTimer timer(&profile, LOCATIONS_MAP_PHASE);
+            locations_list = createLocationsMap(base_index, window_size);
+        }
 
         /* get an ordered list of block numbers to assign writes to. Blocks are ordered by block score function
          * in ascending order.
          */
-        vector<int> blocks = getBlockOrdering(base_index);
+        vector<int> blocks = getBlockOrdering(base_index, window_size);
 
         /* find the assignment for each page in the window. we do this by populating each
          * block at a time according to the blocks vector.
@@ -421,37 +1169,66 @@ public:
 
     }
 
-    vector<int> getBlockOrdering(unsigned long long base_index) const {
-        vector<int> block_list;
-        vector<pair<int,double>> block_scores;
-
+    /* order the free blocks and the full blocks of V[Y]..V[Y+k] by block score in ascending order (ties are
+     * kept in the order we collect the blocks). only the candidate budget of the full blocks is scored, the rest
+     * are appended in bucket order after the scored blocks.
+     * the assignment only consumes blocks until it placed window_size writes, so we only sort the shortest
+     * prefix that has room for the whole window (and leave the rest of the blocks unordered).
+     */
+    vector<int> getBlockOrdering(unsigned long long base_index, unsigned int window_size) const {
+        vector<int> candidates;
         for (auto block : ftl->freeList){
-            double score = ftl->getBlockScore(block->blockNo, base_index, writing_sequence);
-            block_scores.emplace_back((pair<int,double>{block->blockNo,score}));
+            candidates.push_back(block->blockNo);
         }
+        unsigned int number_of_free_blocks = candidates.size();
 
-        //TODO: adjust k
         ftl->updateMinValid();
-        for (int k = ftl->Y ; k <= (page_dist == UNIFORM ? ftl->Y + 1 : PAGES_PER_BLOCK-1) ; k++) {
-            for (int block_num : ftl->V[k]) {
-                double score = ftl->getBlockScore(block_num, base_index, writing_sequence);
-                block_scores.emplace_back(pair<int, double>{block_num, score});
-            }
+        int buckets = ftl->candidate_buckets;
+        if (buckets == DEFAULT_CANDIDATE_BUCKETS){
+            buckets = page_dist == UNIFORM ? 1 : config.pages_per_block - 1 - ftl->Y;
+        }
+        ftl->getCandidateBlocks(&candidates, buckets, NO_CANDIDATE_BUDGET);
+        unsigned int number_to_score = candidates.size();
+        if (ftl->candidate_budget != NO_CANDIDATE_BUDGET && number_of_free_blocks + ftl->candidate_budget < number_to_score){
+            number_to_score = number_of_free_blocks + ftl->candidate_budget;
         }
 
-        std::sort(block_scores.begin(),block_scores.end(),[] (const pair<int,double>& l_val, const pair<int,double>& r_val) {
-            return l_val.second < r_val.second;
-        });
+        /* (score, position in candidates) pairs, so the order is total and the partial sort is deterministic */
+        vector<double> scores(number_to_score);
+        ftl->scoreBlocks(candidates.data(), number_to_score, base_index, writing_sequence, scores.data());
+        vector<pair<double,int>> block_scores;
+        block_scores.reserve(number_to_score);
+        for (unsigned int pos = 0; pos < number_to_score; pos++){
+            block_scores.emplace_back(scores[pos], pos);
+        }
+
+        unsigned long long capacity = 0;
+        unsigned int sorted = 0;
+        unsigned int step = window_size / config.pages_per_block + 1;
+        while (sorted < block_scores.size() && capacity < window_size){
+            /* the unsorted suffix only holds blocks with higher scores than the sorted prefix */
+            unsigned int end = min((unsigned int)block_scores.size(), sorted + step);
+            std::partial_sort(block_scores.begin() + sorted, block_scores.begin() + end, block_scores.end());
+            for (; sorted < end; sorted++){
+                capacity += config.pages_per_block - ftl->blocks[candidates[block_scores[sorted].second]].valid;
+            }
+            step *= 2;
+        }
 
+        vector<int> block_list;
+        block_list.reserve(candidates.size());
         for (auto pair : block_scores){
-            block_list.emplace_back(pair.first);
+            block_list.emplace_back(candidates[pair.second]);
+        }
+        for (unsigned int pos = number_to_score; pos < candidates.size(); pos++){
+            block_list.emplace_back(candidates[pos]);
         }
 
         return block_list;
     }
 
     void updateBlockNumAndWritesCount(int* i, int* writes_in_block, vector<int> blocks) const{
-        while (*writes_in_block == PAGES_PER_BLOCK){
+        while (*writes_in_block == config.pages_per_block){
             (*i)++;
             *writes_in_block = ftl->getValidWritesInBlock(blocks[*i]);
         }
@@ -464,7 +1241,7 @@ public:
         updateBlockNumAndWritesCount(&i,&writes_in_block,blocks);
 
         /* assign all invalid pages. i.e pages that will be overwritten within this window */
-        auto next_block_indexes = getNextBlockIndexes(locations_list,PAGES_PER_BLOCK-writes_in_block);
+        auto next_block_indexes = getNextBlockIndexes(locations_list,config.pages_per_block-writes_in_block);
         while(!next_block_indexes.empty()){
             for (unsigned int j = 0 ; j < next_block_indexes.size() ; j++){
                 /* NOTE: loc represents the absolute location in the writing_sequence, but we want to access
@@ -478,7 +1255,7 @@ public:
 
             writes_in_block += next_block_indexes.size();
             updateBlockNumAndWritesCount(&i,&writes_in_block,blocks);
-            next_block_indexes = getNextBlockIndexes(locations_list,PAGES_PER_BLOCK-writes_in_block);
+            next_block_indexes = getNextBlockIndexes(locations_list,config.pages_per_block-writes_in_block);
         }
 
         /* assign all local valid pages. i.e pages that will remain valid in the end of this window. In order to do
@@ -530,24 +1307,28 @@ public:
         });
     }
 
+    /* the location of the next write of the page written at page_index */
     unsigned long long pageScore(unsigned long long page_index) const{
-        unsigned int lpn = writing_sequence[page_index];
-        return logical_pages_location_map->at(lpn).getFirstLocationAfterIndex(page_index);
+        return scorer->nextOccurrence(page_index);
     }
 
     void runGenerationalSimulation(int num_of_gens, unsigned long long window_size) {
-        if (reach_steady_state){
-            reachSteadyState();
-        }
-
-        for (int j = 0; j < num_of_gens; ++j) {
-            Block* new_gen_block = nullptr;
-            ftl->gen_blocks.insert({j, new_gen_block});
+        unsigned long long first_write = startRun(window_size, num_of_gens);
+        ScopedTimer timer(&profile, SIMULATION_PHASE);
+
+        /* a resumed simulation has the generation blocks of its checkpoint */
+        if (first_write == 0) {
+            for (int j = 0; j < num_of_gens; ++j) {
+                Block* new_gen_block = nullptr;
+                ftl->gen_blocks.insert({j, new_gen_block});
+            }
         }
 
-        for (unsigned long long i = 0; i < window_size; ++i) {
+        for (unsigned long long i = first_write; i < window_size; ++i) {
+            unsigned int lpn = pageAt(i);
             int generation = getGeneration(i, num_of_gens);
-            ftl->writeGenerational(data, writing_sequence[i], generation, writing_sequence, i);
+            ftl->writeGenerational(pageData(lpn), lpn, generation, writing_sequence, i);
+            afterWrite(i + 1);
         }
         for(std::map<int,Block*>::iterator it = ftl->gen_blocks.begin(); it!=ftl->gen_blocks.end(); it++){
             /* push generational blocks to freelist */
@@ -557,21 +1338,22 @@ public:
             }
         }
         ftl->gen_blocks.clear();
-        for (unsigned long long i = window_size; i < NUMBER_OF_PAGES; i++) {
-            ftl->write(data,writing_sequence[i],GREEDY, writing_sequence, i);
+        for (unsigned long long i = max(window_size, first_write); i < config.number_of_pages; i++) {
+            unsigned int lpn = pageAt(i);
+            ftl->write(pageData(lpn),lpn,GREEDY, writing_sequence, i);
+            afterWrite(i + 1);
         }
+        finishRun();
     }
 
     int getGeneration(unsigned long long page_index, int num_of_gens) const{
         unsigned long long page_score = pageScore(page_index) - page_index;
-        int interval = (PAGES_PER_BLOCK*LOGICAL_BLOCK_NUMBER)/num_of_gens; //TODO: adjust this
-        unsigned long long bound = interval;
-        for (int i = 0; i < num_of_gens-1; ++i) {
-            if(page_score < bound)
-                return i;
-            bound += interval;
-        }
-        return num_of_gens - 1;
+        int interval = (config.pages_per_block*config.logical_blocks)/num_of_gens; //TODO: adjust this
+        /* generation i holds the pages that are rewritten within [i*interval, (i+1)*interval) writes */
+        if (interval == 0 || page_score / interval >= (unsigned long long)num_of_gens - 1){
+            return num_of_gens - 1;
+        }
+        return (int)(page_score / interval);
     }
 
 };
@@ -26,9 +26,19 @@ Algorithm algoStringToEnum(const char* string){
     if (strcmp(string,"writing_assignment") == 0){
         return WRITING_ASSIGNMENT;
     }
+    if (strcmp(string,"cost_benefit") == 0){
+        return COST_BENEFIT;
+    }
+    if (strcmp(string,"cat") == 0){
+        return COST_AGE_TIMES;
+    }
     return INVALID_ALGO;
 }
 
+bool isOnlineAlgorithm(Algorithm algorithm){
+    return algorithm == GREEDY || algorithm == COST_BENEFIT || algorithm == COST_AGE_TIMES;
+}
+
 PageDistribution distributionStringToEnum(const char* string){
     if (strcmp(string,"uniform") == 0){
         return UNIFORM;
@@ -36,6 +46,21 @@ PageDistribution distributionStringToEnum(const char* string){
     if (strcmp(string,"hot_cold") == 0){
         return HOT_COLD;
     }
+    if (strcmp(string,"trace") == 0){
+        return TRACE;
+    }
+    if (strcmp(string,"zipf") == 0){
+        return ZIPF;
+    }
+    if (strcmp(string,"tiers") == 0){
+        return TIERED;
+    }
+    if (strcmp(string,"tpcc") == 0){
+        return TPCC;
+    }
+    if (strcmp(string,"ycsb") == 0){
+        return YCSB;
+    }
     return INVALID_DIST;
 }
 
@@ -47,3 +72,67 @@ WindowSizeFlag windowSizeFlagToEnum(const char* string){
     return INVALID_WINDOW_SIZE_FLAG;
 }
 
+PayloadMode payloadModeStringToEnum(const char* string){
+    if(strcmp(string, "none") == 0)
+        return NO_PAYLOAD;
+    if(strcmp(string, "real") == 0)
+        return REAL_PAYLOAD;
+    return INVALID_PAYLOAD_MODE;
+}
+
+TraceFormat traceFormatStringToEnum(const char* string){
+    if(strcmp(string, "msr") == 0)
+        return MSR_TRACE;
+    if(strcmp(string, "blkparse") == 0)
+        return BLKPARSE_TRACE;
+    if(strcmp(string, "binary") == 0)
+        return BINARY_TRACE;
+    return INVALID_TRACE_FORMAT;
+}
+
+LbaMapping lbaMappingStringToEnum(const char* string){
+    if(strcmp(string, "fold") == 0)
+        return FOLD_LBA;
+    if(strcmp(string, "dense") == 0)
+        return DENSE_LBA;
+    return INVALID_LBA_MAPPING;
+}
+
+TelemetryUnit telemetryUnitStringToEnum(const char* string){
+    if(strcmp(string, "erases") == 0)
+        return TELEMETRY_ERASES;
+    if(strcmp(string, "writes") == 0)
+        return TELEMETRY_WRITES;
+    return INVALID_TELEMETRY_UNIT;
+}
+
+TelemetryFormat telemetryFormatStringToEnum(const char* string){
+    if(strcmp(string, "csv") == 0)
+        return CSV_TELEMETRY;
+    if(strcmp(string, "binary") == 0)
+        return BINARY_TELEMETRY;
+    return INVALID_TELEMETRY_FORMAT;
+}
+
+const char* phaseEnumToString(Phase phase){
+    switch (phase) {
+        case SEQUENCE_PHASE:
+            return "sequence_generation";
+        case SCORER_PHASE:
+            return "lookahead_index";
+        case LOCATIONS_MAP_PHASE:
+            return "locations_map";
+        case WARMUP_PHASE:
+            return "warmup";
+        case SIMULATION_PHASE:
+            return "simulation";
+        case VICTIM_SELECTION_PHASE:
+            return "victim_selection";
+        case RELOCATION_PHASE:
+            return "relocation";
+        case CHECKPOINT_PHASE:
+            return "checkpoints";
+        default:
+            return "invalid";
+    }
+}
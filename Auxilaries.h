@@ -7,36 +7,77 @@
 
 #include <cstring>
 
-typedef enum {
-    FREE_LOGICAL, USED_LOGICAL
-} LogicalPageStatus;
+/* page mapping sentinels. physical page numbers and logical page numbers are
+ * 32 bit indices, so T*Z and U*Z must be smaller than these values.
+ */
+#define UNMAPPED 0xFFFFFFFFu
+#define NO_LPN 0xFFFFFFFFu
 
 typedef enum {
     FREE_PHYSICAL, OBSOLETE, VALID
 } PhysicalPageStatus;
 
 typedef enum {
-    UNIFORM, HOT_COLD, INVALID_DIST
+    UNIFORM, HOT_COLD, TRACE, ZIPF, TIERED, TPCC, YCSB, INVALID_DIST
 } PageDistribution;
 
 typedef enum {
-    GREEDY, GREEDY_LOOKAHEAD, GENERATIONAL, WRITING_ASSIGNMENT, INVALID_ALGO
+    GREEDY, GREEDY_LOOKAHEAD, GENERATIONAL, WRITING_ASSIGNMENT, COST_BENEFIT, COST_AGE_TIMES, INVALID_ALGO
 } Algorithm;
 
-typedef enum {
-    HOT, COLD, COIN_TOSS
-} RandVariable;
-
 typedef enum {
     WINDOW_SIZE_ON, WINDOW_SIZE_OFF, INVALID_WINDOW_SIZE_FLAG
 }WindowSizeFlag;
 
+typedef enum {
+    NO_PAYLOAD, REAL_PAYLOAD, INVALID_PAYLOAD_MODE
+} PayloadMode;
+
+typedef enum {
+    MSR_TRACE, BLKPARSE_TRACE, BINARY_TRACE, INVALID_TRACE_FORMAT
+} TraceFormat;
+
+typedef enum {
+    FOLD_LBA, DENSE_LBA, INVALID_LBA_MAPPING
+} LbaMapping;
+
+typedef enum {
+    TELEMETRY_ERASES, TELEMETRY_WRITES, INVALID_TELEMETRY_UNIT
+} TelemetryUnit;
+
+typedef enum {
+    CSV_TELEMETRY, BINARY_TELEMETRY, INVALID_TELEMETRY_FORMAT
+} TelemetryFormat;
+
+/* the timed phases of a simulation (see Profile.h) */
+typedef enum {
+    SEQUENCE_PHASE, SCORER_PHASE, LOCATIONS_MAP_PHASE, WARMUP_PHASE, SIMULATION_PHASE, VICTIM_SELECTION_PHASE,
+    RELOCATION_PHASE, CHECKPOINT_PHASE, NUMBER_OF_PHASES
+} Phase;
+
 Algorithm algoStringToEnum(const char* string);
 
+/* whether the algorithm picks its GC victims without future knowledge (GREEDY, COST_BENEFIT and COST_AGE_TIMES),
+ * so it doesn't need the writing sequence ahead of the current write
+ */
+bool isOnlineAlgorithm(Algorithm algorithm);
+
 PageDistribution distributionStringToEnum(const char* string);
 
 WindowSizeFlag windowSizeFlagToEnum(const char* string);
 
+PayloadMode payloadModeStringToEnum(const char* string);
+
+TraceFormat traceFormatStringToEnum(const char* string);
+
+LbaMapping lbaMappingStringToEnum(const char* string);
+
+TelemetryUnit telemetryUnitStringToEnum(const char* string);
+
+TelemetryFormat telemetryFormatStringToEnum(const char* string);
+
+const char* phaseEnumToString(Phase phase);
+
 unsigned int min(unsigned int a,unsigned int b);
 
 #endif //FLASHGC_AUXILARIES_H
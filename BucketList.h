@@ -0,0 +1,176 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	BucketList is an intrusive bucketed index of items (block numbers). Every item belongs to at most one
+ *	bucket, and every bucket is a doubly-linked list threaded through per-item prev/next arrays.
+ *	The FTL uses it to keep the blocks ordered by their number of valid pages: bucket i holds all the
+ *	(full) blocks with exactly i valid pages.
+ *	complexity: insert, erase and moving a block between buckets are O(1). retrieval of the minimum
+ *	non-empty bucket is O(1) amortized - we track a lower bound of the minimum bucket and only advance it
+ *	lazily when it is queried.
+ */
+
+#ifndef FLASHGC_BUCKETLIST_H
+#define FLASHGC_BUCKETLIST_H
+
+#include <cassert>
+#include <vector>
+
+#define NO_ITEM -1
+
+using std::vector;
+
+class BucketList {
+public:
+
+    /* forward iterator over the items of a single bucket, in insertion order */
+    class Iterator {
+    public:
+        Iterator(const int* next, int item) : next(next), item(item) {}
+
+        int operator*() const {
+            return item;
+        }
+
+        Iterator& operator++() {
+            item = next[item];
+            return *this;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return item != other.item;
+        }
+
+    private:
+        const int* next;
+        int item;
+    };
+
+    /* read-only view of a single bucket. this lets the callers keep using the V[i].size(), V[i].begin()
+     * and range-based for loops like they did when V was an array of sets.
+     */
+    class Bucket {
+    public:
+        Bucket(const BucketList* owner, int bucket) : owner(owner), bucket(bucket) {}
+
+        int size() const {
+            return owner->count[bucket];
+        }
+
+        bool empty() const {
+            return owner->count[bucket] == 0;
+        }
+
+        /* the item that was inserted first to this bucket, or NO_ITEM if the bucket is empty */
+        int front() const {
+            return owner->head[bucket];
+        }
+
+        Iterator begin() const {
+            return Iterator(owner->next.data(), owner->head[bucket]);
+        }
+
+        Iterator end() const {
+            return Iterator(owner->next.data(), NO_ITEM);
+        }
+
+    private:
+        const BucketList* owner;
+        int bucket;
+    };
+
+    BucketList(int number_of_buckets, int number_of_items) :
+            head(number_of_buckets, NO_ITEM), tail(number_of_buckets, NO_ITEM), count(number_of_buckets, 0),
+            prev(number_of_items, NO_ITEM), next(number_of_items, NO_ITEM), bucket_of(number_of_items, NO_ITEM),
+            min_bucket(number_of_buckets) {}
+
+    Bucket operator[](int bucket) const {
+        assert(bucket >= 0 && bucket < (int)count.size());
+        return Bucket(this, bucket);
+    }
+
+    /* the bucket the item currently belongs to, or NO_ITEM if it is not in any bucket */
+    int bucketOf(int item) const {
+        return bucket_of[item];
+    }
+
+    /* append item to the end of the bucket. the item must not belong to any bucket */
+    void insert(int bucket, int item) {
+        assert(bucket_of[item] == NO_ITEM);
+        prev[item] = tail[bucket];
+        next[item] = NO_ITEM;
+        if (tail[bucket] == NO_ITEM) {
+            head[bucket] = item;
+        }
+        else {
+            next[tail[bucket]] = item;
+        }
+        tail[bucket] = item;
+        count[bucket]++;
+        bucket_of[item] = bucket;
+        if (bucket < min_bucket) {
+            min_bucket = bucket;
+        }
+    }
+
+    /* remove item from the bucket. like set::erase, this is a no-op if the item is not in this bucket */
+    void erase(int bucket, int item) {
+        if (bucket_of[item] != bucket) {
+            return;
+        }
+        if (prev[item] == NO_ITEM) {
+            head[bucket] = next[item];
+        }
+        else {
+            next[prev[item]] = next[item];
+        }
+        if (next[item] == NO_ITEM) {
+            tail[bucket] = prev[item];
+        }
+        else {
+            prev[next[item]] = prev[item];
+        }
+        prev[item] = NO_ITEM;
+        next[item] = NO_ITEM;
+        count[bucket]--;
+        bucket_of[item] = NO_ITEM;
+    }
+
+    /* move item from one bucket to the end of another */
+    void move(int from, int to, int item) {
+        assert(bucket_of[item] == from);
+        erase(from, item);
+        insert(to, item);
+    }
+
+    /* get the minimal non-empty bucket, or NO_ITEM if all buckets are empty */
+    int minBucket() {
+        while (min_bucket < (int)count.size() && count[min_bucket] == 0) {
+            min_bucket++;
+        }
+        return min_bucket < (int)count.size() ? min_bucket : NO_ITEM;
+    }
+
+    int numberOfBuckets() const {
+        return (int)count.size();
+    }
+
+private:
+    /* per bucket: first item, last item and number of items */
+    vector<int> head;
+    vector<int> tail;
+    vector<int> count;
+
+    /* per item: the neighbours in its bucket list and the bucket it belongs to */
+    vector<int> prev;
+    vector<int> next;
+    vector<int> bucket_of;
+
+    /* lower bound of the minimal non-empty bucket */
+    int min_bucket;
+};
+
+#endif //FLASHGC_BUCKETLIST_H
@@ -0,0 +1,251 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	A checkpoint file holds the state of a simulation after the steady state warmup (the FTL, the random state and
+ *	the page data), so later runs with the same geometry and the same random state can load it instead of warming
+ *	up again. A running checkpoint (CHECKPOINT_RUNNING) is saved periodically during the simulation itself, and
+ *	also holds the position in the writing sequence, so a simulation that was stopped can be resumed from it.
+ *	The file is written next to its path and renamed over it when it is complete, so a simulation that is stopped
+ *	while it saves a checkpoint leaves the previous one intact.
+ *
+ *	Layout (all the fields are in the byte order of the machine that wrote the file, little endian on x86/ARM):
+ *	CheckpointHeader - the geometry, the random state the warmup started from and the size of the state.
+ *	state            - the sections of the state, in the order they were written (see FTL::saveState and
+ *	                   AlgoRunner::saveSteadyState). every section is a plain array, so loading is a copy out of
+ *	                   the mapped file.
+ */
+
+#ifndef FLASHGC_CHECKPOINT_H
+#define FLASHGC_CHECKPOINT_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "SimConfig.h"
+
+#define CHECKPOINT_MAGIC "FGCCKP1"
+#define CHECKPOINT_VERSION 2
+
+/* CheckpointHeader flags */
+#define CHECKPOINT_HAS_SEED 1
+#define CHECKPOINT_REAL_PAYLOAD 2
+#define CHECKPOINT_RUNNING 4
+
+class CheckpointHeader {
+public:
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+
+    /* the geometry, which must match the simulation that loads the checkpoint */
+    uint32_t physical_blocks;
+    uint32_t logical_blocks;
+    uint32_t pages_per_block;
+    uint32_t page_size;
+
+    /* the seed of the simulation, if flags has CHECKPOINT_HAS_SEED */
+    uint64_t seed;
+
+    /* the random state when the warmup started. the checkpoint is only loaded from the same state, so the
+     * simulation is the same as if it warmed up by itself.
+     */
+    uint32_t random_state[4];
+
+    /* number of writes of the warmup */
+    uint64_t warmup_writes;
+
+    /* number of bytes after the header */
+    uint64_t state_size;
+
+    CheckpointHeader() :
+            version(CHECKPOINT_VERSION), flags(0), physical_blocks(0), logical_blocks(0), pages_per_block(0),
+            page_size(0), seed(0), random_state(), warmup_writes(0), state_size(0) {
+        memcpy(magic, CHECKPOINT_MAGIC, sizeof(magic));
+    }
+
+    explicit CheckpointHeader(const SimConfig& config) : CheckpointHeader() {
+        physical_blocks = config.physical_blocks;
+        logical_blocks = config.logical_blocks;
+        pages_per_block = config.pages_per_block;
+        page_size = config.page_size;
+    }
+
+    bool sameGeometry(const SimConfig& config) const {
+        return physical_blocks == (uint32_t)config.physical_blocks && logical_blocks == (uint32_t)config.logical_blocks &&
+               pages_per_block == (uint32_t)config.pages_per_block && page_size == (uint32_t)config.page_size;
+    }
+};
+
+/* the header is written as is, so its layout must not depend on the compiler */
+static_assert(sizeof(CheckpointHeader) == 72, "CheckpointHeader must not have padding");
+
+class CheckpointWriter {
+public:
+    /* create path (or replace it on close). the header is rewritten with the state size on close */
+    CheckpointWriter(const char* path, const CheckpointHeader& header) :
+            header(header), path(path), temp_path(std::string(path) + ".tmp") {
+        file = fopen(temp_path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "Error! Could not create checkpoint file " << path << "." << std::endl;
+            exit(-1);
+        }
+        this->header.state_size = 0;
+        put(&this->header, sizeof(CheckpointHeader));
+    }
+
+    ~CheckpointWriter() {
+        if (file) {
+            close();
+        }
+    }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    void write(const void* buffer, size_t size) {
+        put(buffer, size);
+        header.state_size += size;
+    }
+
+    template<typename T>
+    void writeValue(const T& value) {
+        write(&value, sizeof(T));
+    }
+
+    /* write the final header and move the file to its path. returns the size of the file */
+    unsigned long long close() {
+        if (fseek(file, 0, SEEK_SET) != 0) {
+            fail();
+        }
+        put(&header, sizeof(CheckpointHeader));
+        if (fflush(file) != 0 || fsync(fileno(file)) != 0 || fclose(file) != 0) {
+            file = nullptr;
+            fail();
+        }
+        file = nullptr;
+        if (rename(temp_path.c_str(), path) != 0) {
+            fail();
+        }
+        return sizeof(CheckpointHeader) + header.state_size;
+    }
+
+private:
+    void put(const void* buffer, size_t size) {
+        if (size && fwrite(buffer, 1, size, file) != size) {
+            fail();
+        }
+    }
+
+    [[noreturn]] void fail() const {
+        std::cerr << "Error! Could not write checkpoint file " << path << "." << std::endl;
+        exit(-1);
+    }
+
+    CheckpointHeader header;
+    const char* path;
+    std::string temp_path;
+    FILE* file;
+};
+
+class CheckpointReader {
+public:
+    /* map path and check its header. the state is read in the order it was written */
+    explicit CheckpointReader(const char* path) : path(path), position(0) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error! Could not open checkpoint file " << path << "." << std::endl;
+            exit(-1);
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || (unsigned long long)file_stat.st_size < sizeof(CheckpointHeader)) {
+            std::cerr << "Error! " << path << " is not a checkpoint file." << std::endl;
+            exit(-1);
+        }
+        mapped_size = file_stat.st_size;
+        void* mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Error! Could not map checkpoint file " << path << "." << std::endl;
+            exit(-1);
+        }
+        begin = (const unsigned char*)mapped;
+        memcpy(&file_header, begin, sizeof(CheckpointHeader));
+        if (memcmp(file_header.magic, CHECKPOINT_MAGIC, sizeof(file_header.magic)) != 0 ||
+            file_header.version != CHECKPOINT_VERSION) {
+            std::cerr << "Error! " << path << " is not a checkpoint file (or was written by another version)."
+                      << std::endl;
+            exit(-1);
+        }
+        if (file_header.state_size != mapped_size - sizeof(CheckpointHeader)) {
+            corrupted();
+        }
+        position = sizeof(CheckpointHeader);
+    }
+
+    ~CheckpointReader() {
+        munmap((void*)begin, mapped_size);
+    }
+
+    CheckpointReader(const CheckpointReader&) = delete;
+    CheckpointReader& operator=(const CheckpointReader&) = delete;
+
+    const CheckpointHeader& header() const {
+        return file_header;
+    }
+
+    void read(void* buffer, size_t size) {
+        if (size > mapped_size - position) {
+            corrupted();
+        }
+        memcpy(buffer, begin + position, size);
+        position += size;
+    }
+
+    template<typename T>
+    T readValue() {
+        T value;
+        read(&value, sizeof(T));
+        return value;
+    }
+
+    /* a value that must be in [0, limit) */
+    template<typename T>
+    T readIndex(T limit) {
+        T value = readValue<T>();
+        if (value < 0 || value >= limit) {
+            corrupted();
+        }
+        return value;
+    }
+
+    /* the whole state must have been read */
+    void finish() const {
+        if (position != mapped_size) {
+            corrupted();
+        }
+    }
+
+    [[noreturn]] void corrupted() const {
+        std::cerr << "Error! Checkpoint file " << path << " is truncated or corrupted." << std::endl;
+        exit(-1);
+    }
+
+private:
+    CheckpointHeader file_header;
+    const char* path;
+    const unsigned char* begin;
+    size_t mapped_size;
+    size_t position;
+};
+
+#endif //FLASHGC_CHECKPOINT_H
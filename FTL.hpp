@@ -13,159 +13,171 @@
 #include <set>
 #include <map>
 #include <vector>
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
 #include "Auxilaries.h"
+#include "BucketList.h"
+#include "Checkpoint.h"
+#include "LookaheadScorer.h"
+#include "Profile.h"
+#include "ThreadPool.h"
+#include "SimConfig.h"
 #include "main.hpp"
 
 /* Main module for the Flash simulation */
 
 #define NA	-15
 #define BLOCK_FULL -71
+#define DEFAULT_CANDIDATE_BUCKETS -1
+#define NO_CANDIDATE_BUDGET 0
+
+/* with a thread pool, candidate blocks are scored in batches of this many blocks per thread */
+#define SCORE_BATCH_PER_THREAD 4
+
+/* the most blocks of every bucket of V the cost-age-times victim selection scores */
+#define CAT_CANDIDATES_PER_BUCKET 16
 
 using std::map;
 using std::vector;
 using std::set;
 using std::pair;
 
-/* forward decleration */
-class PhysicalPage;
-
-/* The Logical Page data structure */
+/* the Physical Block data structure.
+ * the pages of all blocks are stored contiguously in the FTL physical-to-logical
+ * array, and each block only holds a pointer to its own Z entries. an entry
+ * holds the logical page number that is mapped to the physical page, or NO_LPN
+ * if the page is free or obsolete (free pages are the ones at or after nextFree).
+ */
 
-class LogicalPage {
+class Block {
 public:
 
-	/* pointer to the physical page the logical page is mapped to */
-
-	PhysicalPage* physicalPage;
+	/* physical block number */
 
-	/* logical page status: FREE_LOGICAL or USED_LOGICAL */
+	int blockNo;
 
-	LogicalPageStatus status;
+	/* the Z physical-to-logical entries of this block */
 
-	LogicalPage() :
-			physicalPage(nullptr), status(FREE_LOGICAL) {
-	}
+	unsigned int* pages;
 
-	void clear() {
-		physicalPage = nullptr;
-		status = FREE_LOGICAL;
-	}
+	/* number of logical pages mapped to this block */
 
-};
+	int valid;
 
-/* the Physical Page data structure */
+	/* next free page in the range [0,Z-1] OR NA for full */
 
-class PhysicalPage {
-public:
+	int nextFree;
 
-	/* the number of the physical block */
+	/* the Z*page_size bytes of this block in the FTL payload
+	 * backing store, or nullptr when we don't simulate page data (NO_PAYLOAD)
+	 */
 
-	int blockNo;
+	char* payload;
 
-	/* the number of the physical page within the block */
+	/* incremented every time a page is programmed to the block or the block
+	 * is cleaned. as long as the epoch doesn't change, pages can only leave
+	 * the block (become obsolete).
+	 */
 
-	int pageNo;
+	unsigned int epoch;
 
-	/* physical page status: 	FREE_PHYSICAL - Unused page
-	 * 							OBSOLETE - used but a logical page is no longer
-	 * 							mapped to this page.
-	 * 							VALID - a logical page is mapped to this page
+	/* the time (see clock) a page was last programmed to the block or became
+	 * obsolete in it, and the number of times the block was cleaned. used by
+	 * the cost-benefit victim selection.
 	 */
 
-	PhysicalPageStatus status;
+	long long modified;
+	unsigned int erase_count;
 
-	/* pointer to the logical page which is mapped to this physical page */
+	/* the block geometry and the FTL clock (the number of host writes), set
+	 * by the FTL
+	 */
 
-	LogicalPage* logicalPage;
+	int pages_per_block;
+	int page_size;
+	const long long* clock;
 
-	PhysicalPage() :
-			blockNo(NA), pageNo(NA), status(FREE_PHYSICAL), logicalPage(nullptr) {
+	Block() :
+            blockNo(NA), pages(nullptr), valid(0), nextFree(0), payload(nullptr), epoch(0), modified(0),
+            erase_count(0), pages_per_block(0), page_size(0), clock(nullptr) {
 	}
 
-	/* obsolete handling */
+	/* physical page number of page pageNo in this block */
 
-	void obsolete() {
-		status = OBSOLETE;
-		logicalPage = nullptr;
+	unsigned int physicalPageNumber(int pageNo) const {
+		return (unsigned int)blockNo * pages_per_block + pageNo;
 	}
-};
-
-/* the Physical Block data structure */
-
-class Block {
-public:
-
-	/* physical block number */
-
-	int blockNo;
-
-	/* dynamic array of physical pages of histogram_size PAGES_PER_BLOCK */
-
-	PhysicalPage* pages;
-
-	/* number of logical pages mapped to this block */
-
-	int valid;
-
-	/* next free page in the range [0,Z-1] OR NA for full */
 
-	int nextFree;
+	/* physical page status: 	FREE_PHYSICAL - Unused page
+	 * 							OBSOLETE - used but a logical page is no longer
+	 * 							mapped to this page.
+	 * 							VALID - a logical page is mapped to this page
+	 */
 
-	Block() :
-            blockNo(NA), pages(new PhysicalPage[PAGES_PER_BLOCK]), valid(0), nextFree(
-					0) {
-		for (int i = 0; i < PAGES_PER_BLOCK; i++) {
-			pages[i].pageNo = i;
+	PhysicalPageStatus pageStatus(int pageNo) const {
+		if (nextFree != BLOCK_FULL && pageNo >= nextFree) {
+			return FREE_PHYSICAL;
 		}
-	}
-	~Block() {
-		delete[] pages;
+		return pages[pageNo] == NO_LPN ? OBSOLETE : VALID;
 	}
 
 	/* obsolete pages update */
 
-	void obsolete(PhysicalPage* page) {
+	void obsolete(int pageNo) {
 		valid--;
-		page->obsolete();
+		pages[pageNo] = NO_LPN;
+		modified = *clock;
 	}
 
 
 	/* all valid pages are rewritten contiguously from the beginning of the
-	 * block
+	 * block. we only collect the metadata of the valid pages: their logical
+	 * page numbers and their page numbers in this block. the page data (if we
+	 * simulate it) stays in place until it is relocated.
 	 */
 
-	void copyValidToTempAndClean(char* data, LogicalPage* logicalPages[],
+	void copyValidToTempAndClean(unsigned int logicalPages[], int sourcePages[],
                                  int* counter) {
 		*counter = 0;
 
-		/* read valid data to temp buffer */
-
-		for (int i = 0; i < PAGES_PER_BLOCK; i++) {
-			if (pages[i].status == VALID) {
-				read(data + (*counter) * PAGE_SIZE, pages[i].logicalPage);
-				logicalPages[*counter] = pages[i].logicalPage;
+		for (int i = 0; i < pages_per_block; i++) {
+			if (pages[i] != NO_LPN) {
+				logicalPages[*counter] = pages[i];
+				sourcePages[*counter] = i;
 				(*counter)++;
 			}
-			pages[i].status = FREE_PHYSICAL;
-			pages[i].logicalPage = nullptr;
+			pages[i] = NO_LPN;
 		}
 
 		valid = 0;
 		nextFree = 0;
+		epoch++;
+		erase_count++;
+	}
+
+	/* the data of page pageNo, or nullptr when we don't simulate page data */
+
+	char* pageData(int pageNo) const {
+		return payload ? payload + (size_t)pageNo * page_size : nullptr;
 	}
 
 	/* if block is full, perform clean.
-	 * write data to one physical page.
+	 * write data to one physical page, and map the logical page to it in the
+	 * logical-to-physical table. data may be nullptr, or point to a page of
+	 * the same block that is being compacted (hence memmove).
 	 */
 
-	int write(char* data, LogicalPage* page) {
-		PhysicalPage* current = &(pages[nextFree]);
-		page->physicalPage = current;
-		page->status = USED_LOGICAL;
-		current->logicalPage = page;
-		current->status = VALID;
+	int write(const char* data, unsigned int lpn, unsigned int* mappingTable) {
+		pages[nextFree] = lpn;
+		mappingTable[lpn] = physicalPageNumber(nextFree);
+		if (payload && data) {
+			memmove(pageData(nextFree), data, page_size);
+		}
 		valid++;
-		if (nextFree == PAGES_PER_BLOCK - 1) {
+		epoch++;
+		modified = *clock;
+		if (nextFree == pages_per_block - 1) {
 			nextFree = BLOCK_FULL;
 			return BLOCK_FULL;
 		}
@@ -175,13 +187,32 @@ public:
 		}
 	}
 
-	/* read one page. this is a theoretical implementation for now
-	 * since we don't use the read function in our simulator.
-	 * you can implement this according to your needs.
-	 */
+	/* read one page to buffer. this is a no-op when we don't simulate page data */
+
+	void read(char* buffer, int pageNo) const {
+		if (payload) {
+			memcpy(buffer, pageData(pageNo), page_size);
+		}
+	}
+};
+
+/* a block score computed at some base index. the score is exact for the same
+ * base index as long as the block epoch and number of valid pages did not
+ * change. since the block score can only decrease when the base index moves
+ * forward or when pages become obsolete, as long as the epoch did not change
+ * it is an upper bound for the score of the block at any later base index.
+ */
+
+class CachedBlockScore {
+public:
+	double score;
+	unsigned long long base_index;
+	unsigned int epoch;
+	int valid;
+	bool cached;
 
-	void read(char* buffer, LogicalPage* page) {
-	    // read data to buffer...
+	CachedBlockScore() :
+			score(0), base_index(0), epoch(0), valid(0), cached(false) {
 	}
 };
 
@@ -190,47 +221,60 @@ public:
 class FTL {
 public:
 
-	/* Mapping table of the logical pages */
+	/* the memory geometry and simulation length */
+
+	const SimConfig config;
 
-	LogicalPage* mappingTable;
+	/* Mapping table of the logical pages (logical-to-physical). entry lpn holds
+	 * the physical page number the logical page is mapped to, or UNMAPPED.
+	 */
+
+	unsigned int* mappingTable;
+
+	/* physical-to-logical table. entry ppn holds the logical page mapped to the
+	 * physical page ppn, or NO_LPN for free and obsolete pages. block i owns the
+	 * entries [i*Z, (i+1)*Z).
+	 */
+
+	unsigned int* physicalToLogical;
 
 	/* Array of blocks */
 
-	Block** blocks;
+	Block* blocks;
 
 	/* List of pointers to free pages */
 
 	std::list<Block*> freeList;
 
-	/* V is an array of sets of integers of histogram_size PAGES_PER_BLOCK+1. each
-	 * integer refers to a block number.
-	 * set V[i], 0<=i<=PAGES_PER_BLOCK, is a set of all the blocks with i valid
-	 * pages.
+	/* V is a bucket list of Z+1 buckets. each item refers to a
+	 * block number.
+	 * bucket V[i], 0<=i<=Z, holds all the (full) blocks with i
+	 * valid pages.
 	 */
 
-	set<int>* V;
+	BucketList V;
 
 	/* Y - the minimum number of valid pages in a block */
 
 	int Y;
 
-	/* total number of block erases */
+	/* total number of block erases. the counters are 64 bit, long simulations do billions of writes */
 
-	int erases;
+	long long erases;
 
 	/* number of block erases in steady state phase */
 
-	int erases_steady;
+	long long erases_steady;
 
 	/* logical page writes */
 
-	int logicalPageWrites;
-	int logicalPageWritesSteady;
+	long long logicalPageWrites;
+	long long logicalPageWritesSteady;
 
 	/* physical page writes */
 
-	int physicalPageWrites;
-    int physicalPageWritesSteady;
+	long long physicalPageWrites;
+    long long physicalPageWritesSteady;
 
 	/* blocks for writing pages by generation, used for generational GC algorithm */
 	map<int, Block*> gen_blocks;
@@ -247,37 +291,106 @@ public:
      * */
     std::pair<int,int> optimized_params;
 
-	explicit FTL() :
-            mappingTable(
-					new LogicalPage[LOGICAL_BLOCK_NUMBER * PAGES_PER_BLOCK]), blocks(
-					new Block*[PHYSICAL_BLOCK_NUMBER]), V(
-					new set<int> [PAGES_PER_BLOCK + 1]), Y(0), erases(0), erases_steady(0), logicalPageWrites(
+	/* NO_PAYLOAD - only the page metadata is simulated, and relocation never touches page data.
+	 * REAL_PAYLOAD - the data of all physical pages is kept in one preallocated backing store.
+	 */
+	PayloadMode payload_mode;
+
+	/* the backing store of the page data (T*Z pages), REAL_PAYLOAD only */
+	char* payload;
+	size_t payload_size;
+
+	/* future knowledge for the Look Ahead algorithms. when set, block scores are computed in closed form and
+	 * the scorer is notified of every write of the writing sequence. not owned by the FTL.
+	 */
+	LookaheadScorer* scorer;
+
+	/* when set (and there is a scorer), candidate blocks are scored in parallel. not owned by the FTL. */
+	ThreadPool* pool;
+
+	/* victim selection of the look ahead GC: the candidates are the blocks of V[Y]..V[Y+candidate_buckets] in
+	 * bucket order, and at most candidate_budget of them are scored (NO_CANDIDATE_BUDGET for no limit).
+	 * candidate_buckets may be DEFAULT_CANDIDATE_BUCKETS, in which case each algorithm uses its own default range.
+	 */
+	int candidate_buckets;
+	int candidate_budget;
+
+	/* per block cache of the last computed block score. only used with a scorer */
+	mutable vector<CachedBlockScore> score_cache;
+
+	/* scratch buffers of the block clean functions (Z entries each): the logical page number and the source page
+	 * of every valid page of the block being cleaned
+	 */
+	vector<unsigned int> clean_logical_pages;
+	vector<int> clean_source_pages;
+
+	/* when set, the victim selection and the relocation of every erase are timed, and the block scores are
+	 * counted (see Profile.h). not owned by the FTL.
+	 */
+	Profile* profile;
+
+	explicit FTL(const SimConfig& config, PayloadMode payload_mode = NO_PAYLOAD) :
+            config(config), mappingTable(
+					new unsigned int[config.logicalPages()]), physicalToLogical(
+					new unsigned int[config.physicalPages()]), blocks(
+					new Block[config.physical_blocks]), V(
+					config.pages_per_block + 1, config.physical_blocks), Y(0), erases(0), erases_steady(0), logicalPageWrites(
 					0), logicalPageWritesSteady(0), physicalPageWrites(0), physicalPageWritesSteady(0),
-            print_mode(false) {
-		for (int i = 0; i < PHYSICAL_BLOCK_NUMBER; i++) {
-			blocks[i] = new Block;
-			blocks[i]->blockNo = i;
-			freeList.push_back(blocks[i]);
-			for (int j = 0; j < PAGES_PER_BLOCK; j++) {
-				blocks[i]->pages[j].blockNo = i;
-			}
+            print_mode(false), payload_mode(payload_mode), payload(nullptr), payload_size(0), scorer(nullptr),
+            pool(nullptr), profile(nullptr) {
+		/* page numbers are 32 bit, and the all ones value is reserved for the sentinels */
+		assert(config.physicalPages() < NO_LPN);
+		std::fill(mappingTable, mappingTable + config.logicalPages(), UNMAPPED);
+		std::fill(physicalToLogical, physicalToLogical + config.physicalPages(), NO_LPN);
+		for (int i = 0; i < config.physical_blocks; i++) {
+			blocks[i].blockNo = i;
+			blocks[i].pages = physicalToLogical + (size_t)i * config.pages_per_block;
+			blocks[i].pages_per_block = config.pages_per_block;
+			blocks[i].page_size = config.page_size;
+			blocks[i].clock = &logicalPageWrites;
+			freeList.push_back(&blocks[i]);
 		}
+		if (payload_mode == REAL_PAYLOAD) {
+			allocatePayload();
+		}
+		candidate_buckets = DEFAULT_CANDIDATE_BUCKETS;
+		candidate_budget = NO_CANDIDATE_BUDGET;
+		score_cache.resize(config.physical_blocks);
+		clean_logical_pages.resize(config.pages_per_block);
+		clean_source_pages.resize(config.pages_per_block);
         optimized_params.first = getOptimizedAlphaValParam();
-		optimized_params.second = std::max((int)min(LOGICAL_BLOCK_NUMBER/OVER_LOADING_FACTOR, PHYSICAL_BLOCK_NUMBER-LOGICAL_BLOCK_NUMBER), 1);
+		optimized_params.second = std::max((int)min(config.logical_blocks/OVER_LOADING_FACTOR, config.physical_blocks-config.logical_blocks), 1);
     }
 
 	~FTL() {
 		delete[] mappingTable;
-		for (int i = 0; i < PHYSICAL_BLOCK_NUMBER; i++) {
-			delete blocks[i];
-		}
+		delete[] physicalToLogical;
 		delete[] blocks;
-		delete[] V;
+		if (payload) {
+			munmap(payload, payload_size);
+		}
+	}
+
+	/* map an anonymous backing store for the page data. pages are only
+	 * committed by the OS once they are written to.
+	 */
+	void allocatePayload() {
+		payload_size = (size_t)config.physicalPages() * config.page_size;
+		void* store = mmap(nullptr, payload_size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (store == MAP_FAILED) {
+			std::cerr << "Error! could not allocate " << payload_size << " bytes for the page payload." << std::endl;
+			exit(-1);
+		}
+		payload = (char*)store;
+		for (int i = 0; i < config.physical_blocks; i++) {
+			blocks[i].payload = payload + (size_t)i * config.pages_per_block * config.page_size;
+		}
 	}
 
 	void printHeader() {
 		cout << "Erases\t\tLogical Writes\tY\t";
-		for (int i = 0; i < PAGES_PER_BLOCK + 1; i++) {
+		for (int i = 0; i < config.pages_per_block + 1; i++) {
 			cout << "V[" << i << "]\t";
 		}
 		cout << endl;
@@ -287,7 +400,7 @@ public:
 	// not including blocks in freelist
 	int getNumberOfValidPages(){
 	    int counter = 0;
-	    for (int i=0 ; i < PAGES_PER_BLOCK+1 ; i++){
+	    for (int i=0 ; i < config.pages_per_block+1 ; i++){
 	        counter = counter + (V[i].size() * i);
 	    }
 	    for (auto block : freeList){
@@ -301,14 +414,18 @@ public:
 	 */
 	unsigned int windowSizeAux(){
         int minValid = updateMinValid();
+        if (minValid == NA){
+            /* no full blocks */
+            minValid = config.pages_per_block + 1;
+        }
 
         int counter = 0;
-        if (minValid <= PAGES_PER_BLOCK){
+        if (minValid <= config.pages_per_block){
             counter = minValid * V[minValid].size();
         }
 
-        for (int i = minValid+1 ; i < PAGES_PER_BLOCK+1 ; i++){
-            counter += V[i].size() * PAGES_PER_BLOCK;
+        for (int i = minValid+1 ; i < config.pages_per_block+1 ; i++){
+            counter += V[i].size() * config.pages_per_block;
         }
 
         for (auto block : freeList){
@@ -325,11 +442,11 @@ public:
 	Block* choseMinValidOld() {
 		Block* chosen1 = NULL;
 		int temp1;
-		int minValid1 = PAGES_PER_BLOCK + 1;
-		for (int i = 0; i < PHYSICAL_BLOCK_NUMBER; i++) {
-			temp1 = blocks[i]->valid;
-			if (temp1 < minValid1 && (blocks[i]->nextFree == BLOCK_FULL)) {
-				chosen1 = blocks[i];
+		int minValid1 = config.pages_per_block + 1;
+		for (int i = 0; i < config.physical_blocks; i++) {
+			temp1 = blocks[i].valid;
+			if (temp1 < minValid1 && (blocks[i].nextFree == BLOCK_FULL)) {
+				chosen1 = &blocks[i];
 				minValid1 = temp1;
 			}
 		}
@@ -338,33 +455,72 @@ public:
 	}
 
 	/* finding the block with minimum number of valid pages algorithm:
-	 * go over V1 and V2 from i=0 to the top and find the first i for which
-	 * V1[i] or V2[i] is not empty.
-	 * complexity: update of data structures is O(log(PHYSICAL_BLOCK_NUMBER))
-	 * (the complexity of inserting and deleting from the sets) for each write.
-	 * retrieval of the block with minimum valid pages is O(PAGES_PER_BLOCK).
-	 * now, since when memory is full, number of writes between erases is
-	 * O(PAGES_PER_BLOCK) we get a very fast O(PAGES_PER_BLOCK*log(PHYSICAL_BLOCK_NUMBER)) algorithm.
+	 * V tracks the minimal non-empty bucket, so we simply take the first block
+	 * in V[Y].
+	 * complexity: update of data structures is O(1) for each write (moving a
+	 * block between two intrusive bucket lists).
+	 * retrieval of the block with minimum valid pages is O(1) amortized.
 	 */
 
-	/* returns a pointer to the minimum block on 1st write.
-	 * performs this simply by going over N1 and finding the minimal i for
-	 * which V[i] is not empty.
-	 */
+	/* returns a pointer to the minimum block on 1st write. */
 
 	Block* minBlock() {
 		updateMinValid();
-		return blocks[*(V[Y].begin())];
+		return &blocks[V[Y].front()];
 	}
 
-	/* given a LogicalPage object, find the logical page number */
-    int getLogicalPageNumber(LogicalPage* logical_page) const{
-        for (int lpn = 0 ; lpn < LOGICAL_BLOCK_NUMBER * PAGES_PER_BLOCK; ++lpn) {
-            if (&mappingTable[lpn] == logical_page){
-                return lpn;
-            }
-        }
-        return -1 ; // error
+	/* the cost-benefit victim selection (COST_BENEFIT and COST_AGE_TIMES). cleaning a block with utilization
+	 * u = valid/Z frees 1-u of a block at the cost of reading the block and writing u of it back, and the longer
+	 * ago the block was modified (its age, in host writes) the less likely its valid pages are to be rewritten
+	 * soon. COST_BENEFIT picks the block with the highest age*(1-u)/2u, and COST_AGE_TIMES (CAT) also divides by
+	 * the number of times the block was cleaned, which levels the wear.
+	 * all the blocks of a bucket of V have the same u, and a block is appended to its bucket exactly when it is
+	 * modified, so every bucket is ordered by the modification time (oldest first). for COST_BENEFIT the first
+	 * block of a bucket is the best one, so we only compare Z candidates. for COST_AGE_TIMES we scan every bucket
+	 * from its oldest block, until the age alone can't beat the best score, and at most CAT_CANDIDATES_PER_BUCKET
+	 * blocks of it.
+	 */
+	Block* costBenefitBlock(Algorithm algorithm) {
+		updateMinValid();
+		/* a block with no valid pages costs nothing to clean */
+		if (Y == 0) {
+			return &blocks[V[0].front()];
+		}
+		int best = NA;
+		double best_score = -1;
+		for (int k = Y; k < config.pages_per_block; k++) {
+			double utilization = (double)k / config.pages_per_block;
+			double benefit = (1 - utilization) / (2 * utilization);
+			int scanned = 0;
+			for (int block_num : V[k]) {
+				double score = benefit * (logicalPageWrites - blocks[block_num].modified);
+				/* the rest of the bucket is younger, and the erase count only lowers the score */
+				if (score <= best_score) {
+					break;
+				}
+				if (algorithm == COST_AGE_TIMES) {
+					score /= blocks[block_num].erase_count + 1;
+				}
+				if (score > best_score) {
+					best_score = score;
+					best = block_num;
+				}
+				if (algorithm == COST_BENEFIT || ++scanned == CAT_CANDIDATES_PER_BUCKET) {
+					break;
+				}
+			}
+		}
+		assert(best != NA);
+		return &blocks[best];
+	}
+
+	/* given a physical page, find the logical page number mapped to it, or -1
+	 * if the page is free or obsolete. this is a single lookup in the
+	 * physical-to-logical table.
+	 */
+    int getLogicalPageNumber(int block_num, int page_num) const{
+        unsigned int lpn = blocks[block_num].pages[page_num];
+        return lpn == NO_LPN ? -1 : (int)lpn;
 	}
 
 	/* function to calculate a block score given a writing sequence and base index to
@@ -372,29 +528,69 @@ public:
 	 * pages in the block. for full description of the function logic, parameter adjustment
 	 * experiments and graph results - please see written report
 	 */
-	double getBlockScore(int block_num, unsigned long long base_index, unsigned int* writing_sequence) const{
+	double getBlockScore(int block_num, unsigned long long base_index, const unsigned int* writing_sequence) const{
+        assert(block_num >= 0);
+        if (scorer){
+            const Block& block = blocks[block_num];
+            CachedBlockScore& entry = score_cache[block_num];
+            if (entry.cached && entry.epoch == block.epoch && entry.valid == block.valid && entry.base_index == base_index){
+                return entry.score;
+            }
+            entry.score = scorer->score(block.pages, config.pages_per_block, base_index);
+            if (profile){
+                profile->countScore(block.valid);
+            }
+            entry.base_index = base_index;
+            entry.epoch = block.epoch;
+            entry.valid = block.valid;
+            entry.cached = true;
+            return entry.score;
+        }
+        return getBlockScoreScan(block_num, base_index, writing_sequence);
+	}
+
+	/* an upper bound for the score of a block at base_index, taken from the score cache. HUGE_VAL if the block
+	 * was not scored since it was last programmed.
+	 */
+	double getBlockScoreBound(int block_num, unsigned long long base_index) const{
+        const CachedBlockScore& entry = score_cache[block_num];
+        if (scorer && entry.cached && entry.epoch == blocks[block_num].epoch && entry.base_index <= base_index){
+            return entry.score;
+        }
+        return HUGE_VAL;
+	}
+
+	/* the block score function computed by scanning the writing sequence from the base index. this is
+	 * O(Z*T) per block, and is the reference for the closed form
+	 * computation of LookaheadScorer.
+	 */
+	double getBlockScoreScan(int block_num, unsigned long long base_index, const unsigned int* writing_sequence) const{
         assert(block_num >= 0);
-	    Block* curr_block = blocks[block_num];
+	    const Block* curr_block = &blocks[block_num];
         set<int> pages_in_block;
-        for (int i = 0; i < PAGES_PER_BLOCK; ++i) {
-            if (curr_block->pages[i].logicalPage){
-                pages_in_block.insert(getLogicalPageNumber(curr_block->pages[i].logicalPage));
+        for (int i = 0; i < config.pages_per_block; ++i) {
+            if (curr_block->pages[i] != NO_LPN){
+                pages_in_block.insert(curr_block->pages[i]);
             }
         }
 
         double block_score = 0;
-        //TODO: should we scan until i < NUMBER_OF_PAGES or until i < base_index + PAGES_PER_BLOCK*LOGICAL_BLOCK_NUMBER ?
-        for (unsigned long long i = base_index ; i < base_index + PAGES_PER_BLOCK*PHYSICAL_BLOCK_NUMBER && i < NUMBER_OF_PAGES ; i++){
+        unsigned long long i = base_index;
+        //TODO: should we scan until i < N or until i < base_index + Z*U ?
+        for (; i < base_index + config.pages_per_block*config.physical_blocks && i < config.number_of_pages ; i++){
             if (pages_in_block.find(writing_sequence[i]) != pages_in_block.end()){
                 pages_in_block.erase(writing_sequence[i]);
                 if (pages_in_block.empty()){
-                    return block_score;
+                    break;
                 }
             }
             // TODO: adjust the block score function.
             long long div_value = i - base_index;
             block_score += div_value > 0 ? (pages_in_block.size()/(double)pow(div_value,optimized_params.first)) : pages_in_block.size();
         }
+        if (profile){
+            profile->countScore(i - base_index);
+        }
         return block_score;
 	}
 
@@ -409,7 +605,7 @@ public:
          * */
         int getOptimizedAlphaValParam()
         {
-            float OP = (float)(PHYSICAL_BLOCK_NUMBER-LOGICAL_BLOCK_NUMBER)/LOGICAL_BLOCK_NUMBER;
+            float OP = (float)(config.physical_blocks-config.logical_blocks)/config.logical_blocks;
             ALGO_PARAMS_TABLE
             return -1; // shouldn't get here
         }
@@ -417,70 +613,138 @@ public:
     #undef X
 
 
-    Block* getBestBlockToEvict(unsigned int* writing_sequence, long long base_index) const {
+    Block* getBestBlockToEvict(const unsigned int* writing_sequence, unsigned long long base_index) const {
 
-        vector<pair<int, double>> block_scores;
+        vector<int> candidates;
 
-        // TOOD: adjust k
-        /* the k parameter is adjustable and will decide the number of blocks to examine for each GC */
-        for (int k = Y; k <= Y and k < PAGES_PER_BLOCK; k++) {
+        int buckets = candidate_buckets == DEFAULT_CANDIDATE_BUCKETS ? 0 : candidate_buckets;
+        getCandidateBlocks(&candidates, buckets, candidate_budget);
+	    return &blocks[selectBestBlock(candidates, base_index, writing_sequence)];
+	}
+
+	/* append the full blocks of V[Y]..V[Y+buckets] to candidates, in bucket order, until budget blocks were
+	 * appended (NO_CANDIDATE_BUDGET for all of them). blocks with no obsolete pages (V[Z]) are never candidates.
+	 */
+	void getCandidateBlocks(vector<int>* candidates, int buckets, int budget) const {
+        int appended = 0;
+        for (int k = Y; k <= Y + buckets and k < config.pages_per_block; k++) {
             for (int block_num : V[k]){
+                if (budget != NO_CANDIDATE_BUDGET && appended == budget){
+                    return;
+                }
                 assert(block_num >= 0);
-                double score = getBlockScore(block_num, base_index, writing_sequence);
-                block_scores.emplace_back(pair<int, double>{block_num, score});
+                candidates->push_back(block_num);
+                appended++;
             }
         }
+	}
 
-        /* sort blocks in descending order by block score */
-        std::sort(block_scores.begin(),block_scores.end(),[] (const pair<int,double>& l_val, const pair<int,double>& r_val) {
-            return l_val.second > r_val.second;
+	/* find the candidate with the highest block score (the first one in the candidates order on ties).
+	 * blocks are rescored lazily: we go over the candidates by their cached score bound in descending order,
+	 * and stop once the best exact score we found is higher than the bound of all the remaining candidates.
+	 */
+	int selectBestBlock(const vector<int>& candidates, unsigned long long base_index, const unsigned int* writing_sequence) const {
+        assert(!candidates.empty());
+        vector<pair<double, int>> bounds; // (score bound, position in candidates)
+        bounds.reserve(candidates.size());
+        for (unsigned int pos = 0; pos < candidates.size(); pos++) {
+            bounds.emplace_back(getBlockScoreBound(candidates[pos], base_index), pos);
+        }
+        std::sort(bounds.begin(), bounds.end(), [] (const pair<double, int>& l_val, const pair<double, int>& r_val) {
+            return l_val.first > r_val.first || (l_val.first == r_val.first && l_val.second < r_val.second);
         });
-	    return blocks[block_scores.front().first];
+
+        /* with a thread pool we score a whole batch of candidates at once. we may score a few blocks that the
+         * sequential search would have pruned, but the best block (and so the result) is the same.
+         */
+        unsigned int batch_size = (pool && scorer) ? pool->size() * SCORE_BATCH_PER_THREAD : 1;
+        vector<int> batch;
+        vector<double> scores;
+        int best_pos = NA;
+        double best_score = 0;
+        for (unsigned int next = 0; next < bounds.size();) {
+            if (best_pos != NA && bounds[next].first < best_score) {
+                break;
+            }
+            batch.clear();
+            for (unsigned int i = next; i < bounds.size() && i < next + batch_size; i++) {
+                batch.push_back(candidates[bounds[i].second]);
+            }
+            scores.resize(batch.size());
+            scoreBlocks(batch.data(), batch.size(), base_index, writing_sequence, scores.data());
+            for (unsigned int i = 0; i < batch.size(); i++) {
+                int pos = bounds[next + i].second;
+                if (best_pos == NA || scores[i] > best_score || (scores[i] == best_score && pos < best_pos)) {
+                    best_score = scores[i];
+                    best_pos = pos;
+                }
+            }
+            next += batch.size();
+        }
+        return candidates[best_pos];
 	}
 
-	int updateMinValid(){
-        int minValid = 0;
-        while (V[minValid].size() == 0 && minValid <= PAGES_PER_BLOCK) {
-            minValid++;
+	/* scores[i] = getBlockScore(block_nums[i]). blocks are scored in parallel if we have a thread pool. every block
+	 * is scored by a single thread and only touches its own score cache entry, so this is safe as long as the
+	 * block numbers are distinct.
+	 */
+	void scoreBlocks(const int* block_nums, size_t n, unsigned long long base_index, const unsigned int* writing_sequence,
+                     double* scores) const {
+        auto task = [&] (size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                scores[i] = getBlockScore(block_nums[i], base_index, writing_sequence);
+            }
+        };
+        if (pool && scorer) {
+            pool->parallelFor(n, task);
+        }
+        else {
+            task(0, n);
         }
+	}
 
-        if (minValid > PAGES_PER_BLOCK) {
+	int updateMinValid(){
+        int minValid = V.minBucket();
+        if (minValid == NO_ITEM) {
             return NA;
         }
         Y = minValid;
         return minValid;
 	}
 
-	Block* minBlockWithLookAhead(unsigned int* writing_sequence, long long base_index){
+	Block* minBlockWithLookAhead(const unsigned int* writing_sequence, unsigned long long base_index){
         updateMinValid();
         /* if we have blocks with no valid pages, pick one at random (all are
          * equally good)
          */
         if (Y == 0){
-            return blocks[*(V[Y].begin())];
+            return &blocks[V[Y].front()];
         }
         return getBestBlockToEvict(writing_sequence, base_index);
 	}
 
-	void updateObsolete(Block* block) const {
+	void updateObsolete(Block* block) {
 		if (block->nextFree == BLOCK_FULL) {
             int valid = block->valid;
-            V[valid + 1].erase(block->blockNo);
-            V[valid].insert(block->blockNo);
+            V.move(valid + 1, valid, block->blockNo);
         }
 
 	}
 
-	void copyValidToNewPlace(char* data, LogicalPage* logicalPages[],
+	/* write the valid pages collected from block 'from' to 'to' (and to the
+	 * next free blocks if it fills up). the page data is moved along with the
+	 * metadata only if we simulate it.
+	 */
+	void copyValidToNewPlace(Block* from, unsigned int logicalPages[], int sourcePages[],
                              int counter, Block* to) {
 		Block* current = to;
 		int result;
 		for (int i = 0; i < counter; i++) {
-			logicalPages[i]->clear();
-			result = current->write(data + i * PAGE_SIZE, logicalPages[i]);
+			mappingTable[logicalPages[i]] = UNMAPPED;
+			result = current->write(from->pageData(sourcePages[i]), logicalPages[i], mappingTable);
 			physicalPageWrites++;
 			if (result == BLOCK_FULL) {
-				V[current->valid].insert(current->blockNo);
+				V.insert(current->valid, current->blockNo);
 				freeList.pop_front();
 				current = freeList.front();
 			}
@@ -488,28 +752,34 @@ public:
 	}
 
 	void blockClean(Block* block) {
-		char tempData[PAGES_PER_BLOCK * PAGE_SIZE];
-		LogicalPage* logicalPages[PAGES_PER_BLOCK];
+		unsigned int* logicalPages = clean_logical_pages.data();
+		int* sourcePages = clean_source_pages.data();
 		int counter;
 		Block* current = freeList.front();
-		Block temp;
 
-		block->copyValidToTempAndClean(tempData, logicalPages, &counter);
-		copyValidToNewPlace(tempData, logicalPages, counter, current);
+		block->copyValidToTempAndClean(logicalPages, sourcePages, &counter);
+		copyValidToNewPlace(block, logicalPages, sourcePages, counter, current);
 	}
 
 	void print() {
 		cout << erases << "\t\t" << logicalPageWrites << "\t\t" << Y << "\t";
-		for (int i = 0; i < PAGES_PER_BLOCK + 1; i++) {
+		for (int i = 0; i < config.pages_per_block + 1; i++) {
 			cout << V[i].size() << "\t";
 		}
 
 		cout << endl;
 	}
 
-	void GC() {
+	/* clean one block, picked by the victim selection of an online algorithm (GREEDY, COST_BENEFIT or
+	 * COST_AGE_TIMES)
+	 */
+	void GC(Algorithm algorithm = GREEDY) {
 
-		Block* min = minBlock();
+		Block* min;
+		{
+			ScopedTimer timer(profile, VICTIM_SELECTION_PHASE);
+			min = algorithm == GREEDY ? minBlock() : costBenefitBlock(algorithm);
+		}
 		assert(min);
 
 //		assert(min->valid == choseMinValidOld()->valid);
@@ -521,14 +791,15 @@ public:
 
 		freeList.push_back(min);
 		assert(!freeList.empty());
-		V[min->valid].erase(min->blockNo);
+		V.erase(min->valid, min->blockNo);
+		ScopedTimer timer(profile, RELOCATION_PHASE);
 		blockClean(min);
 
 	}
 
 	void printV() {
 	    cout<<"blocks status:"<<endl;
-        for (int i = 0; i < PAGES_PER_BLOCK+1; i++) {
+        for (int i = 0; i < config.pages_per_block+1; i++) {
             cout<<"V["<<i<<"]: ";
             for (int j : V[i]){
                 cout<<j<<" ";
@@ -537,9 +808,13 @@ public:
         }
 	}
 
-    void GCWithLookAhead(unsigned int* writing_sequence, unsigned int base_index) {
+    void GCWithLookAhead(const unsigned int* writing_sequence, unsigned long long base_index) {
 
-        Block* min = minBlockWithLookAhead(writing_sequence, base_index);
+        Block* min;
+        {
+            ScopedTimer timer(profile, VICTIM_SELECTION_PHASE);
+            min = minBlockWithLookAhead(writing_sequence, base_index);
+        }
 
         assert(min);
 
@@ -552,25 +827,26 @@ public:
 
         freeList.push_back(min);
         assert(!freeList.empty());
-        V[min->valid].erase(min->blockNo);
+        V.erase(min->valid, min->blockNo);
+        ScopedTimer timer(profile, RELOCATION_PHASE);
         blockClean(min);
     }
 
 
-    void updateMappingTable(unsigned int lpn, Block* current) const{
-        Block *obsoletePlace =
-                blocks[mappingTable[lpn].physicalPage->blockNo];
-        obsoletePlace->obsolete(mappingTable[lpn].physicalPage);
+    void updateMappingTable(unsigned int lpn, Block* current) {
+        unsigned int ppn = mappingTable[lpn];
+        Block *obsoletePlace = &blocks[ppn / config.pages_per_block];
+        obsoletePlace->obsolete(ppn % config.pages_per_block);
         if (obsoletePlace != current) {
             updateObsolete(obsoletePlace);
         }
-        mappingTable[lpn].clear();
+        mappingTable[lpn] = UNMAPPED;
 	}
 
-	void write(char* data, unsigned int lpn , Algorithm algorithm , unsigned int* writing_sequence = nullptr,unsigned long long base_index = NA ) {
+	void write(char* data, unsigned int lpn , Algorithm algorithm , const unsigned int* writing_sequence = nullptr,unsigned long long base_index = NA ) {
         if (freeList.empty()){
-            if (algorithm == GREEDY){
-                GC();
+            if (isOnlineAlgorithm(algorithm)){
+                GC(algorithm);
             }
             else {
                 GCWithLookAhead(writing_sequence,base_index);
@@ -578,20 +854,23 @@ public:
         }
         Block *current = freeList.front();
 
-        if (mappingTable[lpn].status != FREE_LOGICAL) {
+        if (mappingTable[lpn] != UNMAPPED) {
             updateMappingTable(lpn,current);
         }
 
-        int result = current->write(data, &(mappingTable[lpn]));
+        int result = current->write(data, lpn, mappingTable);
         physicalPageWrites++;
-        assert(current->valid<= PAGES_PER_BLOCK);
+        assert(current->valid<= config.pages_per_block);
 
         if (result == BLOCK_FULL) {
-            V[current->valid].insert(current->blockNo);
+            V.insert(current->valid, current->blockNo);
             freeList.pop_front();
         }
 
 		logicalPageWrites++;
+		if (scorer){
+		    scorer->onHostWrite(lpn, base_index);
+		}
 	}
 
 
@@ -603,7 +882,7 @@ public:
 		gen_blocks.at(generation) = block_to_assign;
 	}
 
-    void writeGenerational(char* data, unsigned int lpn, int generation, unsigned int* writing_sequence, unsigned long long base_index) {
+    void writeGenerational(char* data, unsigned int lpn, int generation, const unsigned int* writing_sequence, unsigned long long base_index) {
         Block* gen_block = getGenerationalBlock(generation);
         if (!gen_block){
             if (freeList.empty()){
@@ -613,18 +892,21 @@ public:
             updateGenBlock(generation,gen_block);
             freeList.pop_front();
         }
-        if (mappingTable[lpn].status != FREE_LOGICAL) {
+        if (mappingTable[lpn] != UNMAPPED) {
             updateMappingTable(lpn, gen_block);
         }
-        int result = gen_block->write(data, &(mappingTable[lpn]));
+        int result = gen_block->write(data, lpn, mappingTable);
         physicalPageWrites++;
-        assert(gen_block->valid <= PAGES_PER_BLOCK);
+        assert(gen_block->valid <= config.pages_per_block);
 
         if (result == BLOCK_FULL) {
-            V[gen_block->valid].insert(gen_block->blockNo);
+            V.insert(gen_block->valid, gen_block->blockNo);
             updateGenBlock(generation,nullptr);
         }
         logicalPageWrites++;
+        if (scorer){
+            scorer->onHostWrite(lpn, base_index);
+        }
     }
 
     /* this block clean function is quite similar to the original block clean function implemented above,
@@ -632,25 +914,15 @@ public:
      * This implementation better fits the theoretical model of the GC as learned in class
      */
     void NewBlockClean(Block* block) {
-        char data[PAGE_SIZE];
-        LogicalPage *logicalPages[PAGES_PER_BLOCK];
+        unsigned int* logicalPages = clean_logical_pages.data();
+        int* sourcePages = clean_source_pages.data();
         int counter = 0;
-        for (int i = 0; i < PAGES_PER_BLOCK; i++) {
-            if (block->pages[i].status == VALID) {
-                //read(data + (*counter) * PAGE_SIZE, pages[i].logicalPage);
-                logicalPages[counter] = block->pages[i].logicalPage;
-                counter++;
-            }
-            block->pages[i].status = FREE_PHYSICAL;
-            block->pages[i].logicalPage = nullptr;
-        }
-        block->valid = 0;
-        block->nextFree = 0;
+        block->copyValidToTempAndClean(logicalPages, sourcePages, &counter);
 
         /* rewrite valid pages to block */
         for (int i = 0; i < counter; i++) {
-            logicalPages[i]->clear();
-            block->write(data, logicalPages[i]);
+            mappingTable[logicalPages[i]] = UNMAPPED;
+            block->write(block->pageData(sourcePages[i]), logicalPages[i], mappingTable);
             physicalPageWrites++;
         }
     }
@@ -658,12 +930,12 @@ public:
     /* this write function writes a logical page to a specific block.
      * if the block is full we preform a block clean and then write the page
      */
-    void writeToBlock(char* data, int lpn, int block_number){
-	    Block* write_to = blocks[block_number];
-	    while (write_to->nextFree == BLOCK_FULL && write_to->valid == PAGES_PER_BLOCK){
+    void writeToBlock(char* data, int lpn, int block_number, const unsigned int* writing_sequence = nullptr, unsigned long long base_index = NA){
+	    Block* write_to = &blocks[block_number];
+	    while (write_to->nextFree == BLOCK_FULL && write_to->valid == config.pages_per_block){
 	        // error - should not get here. but if we got here we resort to greedy lookahead algorithm.
-	        cout<<"block full! wanted to write page number "<<lpn<<" to block: "<<block_number<<endl;
-	        write(data,lpn,GREEDY_LOOKAHEAD);
+	        cerr<<"block full! wanted to write page number "<<lpn<<" to block: "<<block_number<<endl;
+	        write(data,lpn,GREEDY_LOOKAHEAD,writing_sequence,base_index);
 	        return;
 	    }
 
@@ -674,33 +946,37 @@ public:
             }
 
             freeList.push_back(write_to); // after cleaning this block will have free pages
-            V[write_to->valid].erase(write_to->blockNo);
+            V.erase(write_to->valid, write_to->blockNo);
+            ScopedTimer timer(profile, RELOCATION_PHASE);
             NewBlockClean(write_to);
 	    }
 
-        if (mappingTable[lpn].status != FREE_LOGICAL) {
+        if (mappingTable[lpn] != UNMAPPED) {
             updateMappingTable(lpn,write_to);
         }
 
-        int result = write_to->write(data, &(mappingTable[lpn]));
+        int result = write_to->write(data, lpn, mappingTable);
         physicalPageWrites++;
 
         if (result == BLOCK_FULL) {
-            V[write_to->valid].insert(write_to->blockNo);
+            V.insert(write_to->valid, write_to->blockNo);
             freeList.remove(write_to); // delete block from freelist (must be there)
         }
 
         logicalPageWrites++;
+        if (scorer && writing_sequence){
+            scorer->onHostWrite(lpn, base_index);
+        }
     }
 
     /* deletes all blocks with Z invalid pages, i.e all the block is invalid. */
     void sweepFullBlocks(){
-        for (int i = 0 ; i < PHYSICAL_BLOCK_NUMBER ; i++){
-            if (blocks[i]->nextFree == BLOCK_FULL && blocks[i]->valid == 0){
+        for (int i = 0 ; i < config.physical_blocks ; i++){
+            if (blocks[i].nextFree == BLOCK_FULL && blocks[i].valid == 0){
                 erases++;
-                V[blocks[i]->valid].erase(blocks[i]->blockNo);
-                freeList.push_front(blocks[i]);
-                NewBlockClean(blocks[i]);
+                V.erase(blocks[i].valid, blocks[i].blockNo);
+                freeList.push_front(&blocks[i]);
+                NewBlockClean(&blocks[i]);
             }
         }
     }
@@ -708,28 +984,28 @@ public:
     /* this should used for debugging purposes only. use with small block numbers */
     void printMemoryLayout() const{
         cout<<"       ";
-        for (int i = 0; i < PHYSICAL_BLOCK_NUMBER; ++i) {
+        for (int i = 0; i < config.physical_blocks; ++i) {
             cout<<i<<"    "; // block number
         }
         cout<<endl;
         cout<<"     ";
-        for (int i = 0; i < PHYSICAL_BLOCK_NUMBER; ++i) {
+        for (int i = 0; i < config.physical_blocks; ++i) {
             cout<<"-----";
         }
         cout<<endl;
 
-        for (int i = 0; i < PAGES_PER_BLOCK; ++i) {
+        for (int i = 0; i < config.pages_per_block; ++i) {
             cout<<i<<"   |"; // page number
-            for (int j = 0; j < PHYSICAL_BLOCK_NUMBER; ++j) {
-                if(blocks[j]->pages[i].status == OBSOLETE){
+            for (int j = 0; j < config.physical_blocks; ++j) {
+                PhysicalPageStatus status = blocks[j].pageStatus(i);
+                if(status == OBSOLETE){
                     cout<<" X  |";
                 }
-                if(blocks[j]->pages[i].status == FREE_PHYSICAL){
+                if(status == FREE_PHYSICAL){
                     cout<<"    |";
                 }
-                if(blocks[j]->pages[i].status == VALID){
-                    LogicalPage* logical_page = blocks[j]->pages[i].logicalPage;
-                    int k = getLogicalPageNumber(logical_page);
+                if(status == VALID){
+                    int k = getLogicalPageNumber(j, i);
                     if (k/10 == 0){
                         cout<<"  "<<k<<" |";
                     }
@@ -739,7 +1015,7 @@ public:
                 }
             }
             cout<<endl<<"     ";
-            for (int j = 0; j < PHYSICAL_BLOCK_NUMBER; ++j) {
+            for (int j = 0; j < config.physical_blocks; ++j) {
                 cout<<"-----";
             }
             cout<<endl;
@@ -748,10 +1024,10 @@ public:
 
 	/* get the number of valid page writes in a given block */
     int getValidWritesInBlock(int block_num) const{
-        Block* curr_block = blocks[block_num];
+        const Block* curr_block = &blocks[block_num];
         int valid_writes = 0;
-        for (int i = 0; i < PAGES_PER_BLOCK; ++i) {
-            if (curr_block->pages[i].logicalPage){
+        for (int i = 0; i < config.pages_per_block; ++i) {
+            if (curr_block->pages[i] != NO_LPN){
                 valid_writes++;
             }
         }
@@ -759,12 +1035,111 @@ public:
 	}
 
 
-	void read(char* buffer, int lpn) {
-		if (mappingTable[lpn].status == FREE_LOGICAL) {
+	void read(char* buffer, int lpn) const {
+		if (mappingTable[lpn] == UNMAPPED) {
 			return;
 		}
-		blocks[mappingTable[lpn].physicalPage->blockNo]->read(buffer,
-				&mappingTable[lpn]);
+		blocks[mappingTable[lpn] / config.pages_per_block].read(buffer, mappingTable[lpn] % config.pages_per_block);
+	}
+
+	/* write the state of the FTL (the mapping tables, the blocks, the free list, V, the generation blocks, the
+	 * counters and the page data) to a checkpoint. the score cache is not saved, it is only a cache.
+	 */
+	void saveState(CheckpointWriter* out) const {
+		out->write(mappingTable, sizeof(unsigned int) * config.logicalPages());
+		out->write(physicalToLogical, sizeof(unsigned int) * config.physicalPages());
+		for (int i = 0; i < config.physical_blocks; i++) {
+			out->writeValue<int32_t>(blocks[i].valid);
+			out->writeValue<int32_t>(blocks[i].nextFree);
+			out->writeValue<uint32_t>(blocks[i].epoch);
+			out->writeValue<int64_t>(blocks[i].modified);
+			out->writeValue<uint32_t>(blocks[i].erase_count);
+		}
+		out->writeValue<uint32_t>(freeList.size());
+		for (const Block* block : freeList) {
+			out->writeValue<int32_t>(block->blockNo);
+		}
+		/* V is saved bucket by bucket in the order of the blocks in every bucket, which is the order of the GC */
+		for (int i = 0; i < V.numberOfBuckets(); i++) {
+			out->writeValue<uint32_t>(V[i].size());
+			for (int block_num : V[i]) {
+				out->writeValue<int32_t>(block_num);
+			}
+		}
+		/* a generation that wasn't given a block yet is saved as NA */
+		out->writeValue<uint32_t>(gen_blocks.size());
+		for (const auto& gen_block : gen_blocks) {
+			out->writeValue<int32_t>(gen_block.first);
+			out->writeValue<int32_t>(gen_block.second ? gen_block.second->blockNo : NA);
+		}
+		int64_t counters[] = {Y, erases, erases_steady, logicalPageWrites, logicalPageWritesSteady, physicalPageWrites,
+		                      physicalPageWritesSteady};
+		out->write(counters, sizeof(counters));
+		if (payload) {
+			out->write(payload, payload_size);
+		}
+	}
+
+	/* load the state written by saveState, into an FTL with the same geometry and payload mode */
+	void loadState(CheckpointReader* in) {
+		unsigned int logical_pages = config.logicalPages();
+		unsigned long long physical_pages = config.physicalPages();
+		in->read(mappingTable, sizeof(unsigned int) * logical_pages);
+		in->read(physicalToLogical, sizeof(unsigned int) * physical_pages);
+		for (unsigned int lpn = 0; lpn < logical_pages; lpn++) {
+			if (mappingTable[lpn] != UNMAPPED && mappingTable[lpn] >= physical_pages) {
+				in->corrupted();
+			}
+		}
+		for (int i = 0; i < config.physical_blocks; i++) {
+			blocks[i].valid = in->readIndex<int32_t>(config.pages_per_block + 1);
+			blocks[i].nextFree = in->readValue<int32_t>();
+			blocks[i].epoch = in->readValue<uint32_t>();
+			blocks[i].modified = in->readValue<int64_t>();
+			blocks[i].erase_count = in->readValue<uint32_t>();
+			if (blocks[i].nextFree != BLOCK_FULL && (blocks[i].nextFree < 0 || blocks[i].nextFree >= config.pages_per_block)) {
+				in->corrupted();
+			}
+		}
+		freeList.clear();
+		unsigned int free_blocks = in->readIndex<uint32_t>(config.physical_blocks + 1);
+		for (unsigned int i = 0; i < free_blocks; i++) {
+			freeList.push_back(&blocks[in->readIndex<int32_t>(config.physical_blocks)]);
+		}
+		V = BucketList(config.pages_per_block + 1, config.physical_blocks);
+		for (int i = 0; i < V.numberOfBuckets(); i++) {
+			unsigned int size = in->readIndex<uint32_t>(config.physical_blocks + 1);
+			for (unsigned int j = 0; j < size; j++) {
+				int block_num = in->readIndex<int32_t>(config.physical_blocks);
+				if (V.bucketOf(block_num) != NO_ITEM) {
+					in->corrupted();
+				}
+				V.insert(i, block_num);
+			}
+		}
+		gen_blocks.clear();
+		unsigned int generations = in->readIndex<uint32_t>(config.physical_blocks + 1);
+		for (unsigned int i = 0; i < generations; i++) {
+			int generation = in->readValue<int32_t>();
+			int block_num = in->readValue<int32_t>();
+			if (block_num != NA && (block_num < 0 || block_num >= config.physical_blocks)) {
+				in->corrupted();
+			}
+			gen_blocks[generation] = block_num == NA ? nullptr : &blocks[block_num];
+		}
+		int64_t counters[7];
+		in->read(counters, sizeof(counters));
+		Y = counters[0];
+		erases = counters[1];
+		erases_steady = counters[2];
+		logicalPageWrites = counters[3];
+		logicalPageWritesSteady = counters[4];
+		physicalPageWrites = counters[5];
+		physicalPageWritesSteady = counters[6];
+		if (payload) {
+			in->read(payload, payload_size);
+		}
+		std::fill(score_cache.begin(), score_cache.end(), CachedBlockScore());
 	}
 
 
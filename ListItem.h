@@ -16,7 +16,6 @@
 #include <cmath>
 #include <vector>
 #include <set>
-#include "main.hpp"
 
 #define NOT_EXIST -3
 using std::vector;
@@ -61,13 +60,14 @@ public:
         return location_list.back();
     }
 
-    unsigned long long getFirstLocationAfterIndex(unsigned long long page_index){
+    /* get the first location after page_index, or end (the length of the writing sequence) if there is none */
+    unsigned long long getFirstLocationAfterIndex(unsigned long long page_index, unsigned long long end){
         for (auto i : location_list){
             if (i > page_index){
                 return i;
             }
         }
-        return NUMBER_OF_PAGES;
+        return end;
     }
 
     vector<unsigned long long> getLocationList() const {
@@ -0,0 +1,158 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	LookaheadScorer holds the future knowledge used by the Look Ahead algorithms, and computes the block
+ *	score function in closed form.
+ *	The block score (see FTL::getBlockScore) scans the writing sequence from the base index, and on every step d
+ *	adds (number of block pages that were not rewritten yet)/d^n. This is a sum over the pages of the block, where
+ *	a page whose next write is d_p writes away contributes sum_{d=0}^{d_p-1} 1/d^n (the d=0 term is 1), and a page
+ *	that is not rewritten within the scan horizon H contributes the same sum up to H. With a prefix table of these
+ *	sums, the score of a block is O(valid pages) instead of O(scan horizon).
+ *	In streaming mode (see SequenceStream) only a window of the sequence is known. the stream appends every write
+ *	once it is generated, which is at least H writes before it is written, and a page whose next write wasn't
+ *	generated yet is treated as not rewritten (its next write is length). such a page is not rewritten within H
+ *	writes either way, so the score is the same as with the whole sequence.
+ */
+
+#ifndef FLASHGC_LOOKAHEADSCORER_H
+#define FLASHGC_LOOKAHEADSCORER_H
+
+#include <cmath>
+#include <vector>
+#include "Auxilaries.h"
+
+using std::vector;
+
+class LookaheadScorer {
+public:
+
+    /* @param writing_sequence the writing sequence of the simulation, of the given length.
+     * @param logical_pages the number of logical pages (U*Z).
+     * @param horizon the maximal number of future writes the block score scans (Z*T).
+     * @param power the block score denominator's power n.
+     */
+    LookaheadScorer(const unsigned int* writing_sequence, unsigned long long length, unsigned int logical_pages,
+                    unsigned long long horizon, int power) :
+                    length(length), horizon(horizon), mask(~0ULL), consumed(0), next_occurrence(length),
+                    next_write(logical_pages, length) {
+        /* one backward pass over the writing sequence. next_write[lpn] holds the location of the closest write of
+         * lpn after the current index, so at the end of the pass it holds the first write of every page.
+         */
+        for (unsigned long long i = length; i-- > 0;) {
+            next_occurrence[i] = next_write[writing_sequence[i]];
+            next_write[writing_sequence[i]] = i;
+        }
+
+        initializePrefix(power);
+    }
+
+    /* streaming mode: the writing sequence is given one write at a time with append().
+     * @param buffer_capacity the number of writes the stream keeps (a power of 2). a write must be appended before
+     * it is written, and at most buffer_capacity writes may be appended and not written yet.
+     */
+    LookaheadScorer(unsigned long long length, unsigned int logical_pages, unsigned long long horizon, int power,
+                    unsigned long long buffer_capacity) :
+                    length(length), horizon(horizon), mask(buffer_capacity - 1), consumed(0),
+                    next_occurrence(buffer_capacity, length), next_write(logical_pages, length),
+                    last_appended(logical_pages, length) {
+        initializePrefix(power);
+    }
+
+    /* streaming mode: writing_sequence[index] == lpn. must be called in order */
+    void append(unsigned long long index, unsigned int lpn) {
+        unsigned long long last = last_appended[lpn];
+        if (last != length && last >= consumed) {
+            /* the previous write of lpn is still ahead of us */
+            next_occurrence[last & mask] = index;
+        }
+        else {
+            next_write[lpn] = index;
+        }
+        next_occurrence[index & mask] = length;
+        last_appended[lpn] = index;
+    }
+
+    /* streaming mode: the stream starts at write index (see SequenceStream::skipTo), and the writes before it
+     * were written before the simulation was resumed
+     */
+    void startAt(unsigned long long index) {
+        consumed = index;
+    }
+
+    /* the location of the next write of the page written at index, or length if it is not written again */
+    unsigned long long nextOccurrence(unsigned long long index) const {
+        return next_occurrence[index & mask];
+    }
+
+    /* the location of the next write of lpn, counting from the last host write we were notified of */
+    unsigned long long nextWrite(unsigned int lpn) const {
+        return next_write[lpn];
+    }
+
+    /* must be called after every host write of the writing sequence (in order), so we know when each valid
+     * page will be rewritten
+     */
+    void onHostWrite(unsigned int lpn, unsigned long long index) {
+        if (index >= length) {
+            return;
+        }
+        next_write[lpn] = next_occurrence[index & mask];
+        consumed = index + 1;
+    }
+
+    /* score a block given its physical-to-logical entries (NO_LPN entries are skipped) and a base index */
+    double score(const unsigned int* pages, int number_of_pages, unsigned long long base_index) const {
+        if (base_index >= length) {
+            return 0;
+        }
+        unsigned long long scan = length - base_index < horizon ? length - base_index : horizon;
+        double block_score = 0;
+        for (int i = 0; i < number_of_pages; i++) {
+            if (pages[i] == NO_LPN) {
+                continue;
+            }
+            unsigned long long next = next_write[pages[i]];
+            unsigned long long distance = next > base_index ? next - base_index : 0;
+            block_score += prefix[distance < scan ? distance : scan];
+        }
+        return block_score;
+    }
+
+private:
+    void initializePrefix(int power) {
+        unsigned long long table_size = (horizon < length ? horizon : length) + 1;
+        prefix.resize(table_size);
+        prefix[0] = 0;
+        for (unsigned long long d = 0; d + 1 < table_size; d++) {
+            prefix[d + 1] = prefix[d] + (d > 0 ? 1 / (double)pow(d, power) : 1);
+        }
+    }
+
+    unsigned long long length;
+    unsigned long long horizon;
+
+    /* next_occurrence is indexed by (i & mask): all ones for a whole sequence, buffer_capacity-1 for a stream */
+    unsigned long long mask;
+
+    /* the number of host writes we were notified of */
+    unsigned long long consumed;
+
+    /* next_occurrence[i] is the smallest j > i such that writing_sequence[j] == writing_sequence[i], or length
+     * (in streaming mode: or length if j wasn't appended yet)
+     */
+    vector<unsigned long long> next_occurrence;
+
+    /* per logical page: the location of its next write */
+    vector<unsigned long long> next_write;
+
+    /* streaming mode only: per logical page, the location of its last appended write, or length */
+    vector<unsigned long long> last_appended;
+
+    /* prefix[m] = sum_{d=0}^{m-1} 1/d^n, where the d=0 term is 1 */
+    vector<double> prefix;
+};
+
+#endif //FLASHGC_LOOKAHEADSCORER_H
@@ -10,12 +10,19 @@
  * The need for the custom generator emerged from the fact that the STL rand()
  * returns only 32768 different numbers (between 0 and 32767), less than the
  * range needed for this simulation. Marsaglia's algorithm is fast and performs
- * very well on randomness tests. The STL rand() is used for seeding.
+ * very well on randomness tests. The generator is seeded with SplitMix64 from the --seed of the run (or from
+ * a random value that is printed, see seed()).
  */
 
 /* USAGE:
- * seed() - once before using KISS().
- * KISS().
+ * RandomGenerator rng;
+ * rng.seed(value) - once before using rng.KISS(), for a reproducible run (rng.seed() picks a random value and
+ * returns it, and keeping the default seed is also reproducible).
+ * rng.KISS(), or rng.uniform(range) for a number in [0, range).
+ *
+ * CounterRandom generates the writing sequences. the i-th number of its stream only depends on the key and on i, so
+ * any part of a sequence can be generated on its own (by any thread, in any order) and give the same numbers.
+ * the keys come from rng.streamKey(stream), which only depends on the seed.
  */
 
 #ifndef MYRAND_H_
@@ -26,116 +33,305 @@
 #include <cstdlib>
 #include <cmath>
 #include <random>
-#include "main.hpp"
 #include "Auxilaries.h"
 
+/* the batch generation of CounterRandom has AVX2 and AVX-512 versions, which are picked at run time */
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define COUNTER_RANDOM_SIMD
+#endif
+
 
 using namespace std;
 
-static unsigned int x = 123456789, y = 362436000, z = 521288629, c = 7654321; /* Seed variables */
+/* the SplitMix64 increment and output function (Steele, Lea and Flood). the output function is a bijection, and
+ * hashing a counter with it passes BigCrush.
+ */
+#define SPLITMIX_GAMMA 0x9E3779B97F4A7C15ULL
 
-unsigned int KISS() {
-	unsigned long long t, a = 698769069ULL;
+/* the counter based streams of a run (see RandomGenerator::streamKey) */
+#define SEQUENCE_STREAM 0       /* the writing sequence */
+#define PAGE_ORDER_STREAM 1     /* the page shuffle of the scrambled Zipf distribution */
+#define NURAND_STREAM 2         /* the NURand constant C */
 
-	x = 69069 * x + 12345;
-	y ^= (y << 13);
-	y ^= (y >> 17);
-	y ^= (y << 5); /* y must never be set to zero! */
-	t = a * z + c;
-	c = (t >> 32); /* Also avoid setting z=c=0! */
+/* separates the stream keys of a seed from the KISS state derived from it */
+#define STREAM_KEY_SALT 0xD1B54A32D192ED03ULL
 
-	return x + y + (z = t);
-}
-void seed() {
-	srand(time(nullptr));
-	do {
-		x = time(nullptr);
-		y = pow(rand() % 1621, 3);
-		z = pow(rand() % 251, 4);
-		c = 104729 * rand();
-	} while (y == 0 || z == 0 || c == 0);
+static inline unsigned long long splitMix(unsigned long long z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
 }
 
-static std::uniform_int_distribution<int> num_generator_hot;
-std::default_random_engine gen_hot;
-static std::uniform_int_distribution<int> num_generator_cold;
-std::default_random_engine gen_cold;
-static std::uniform_int_distribution<int> num_generator_toss;
-std::default_random_engine gen_toss;
+/* a random number generator with its own state. every simulation owns one, so simulations running in the same
+ * process (or on different threads) don't share random state.
+ */
+
+class RandomGenerator {
+public:
+    RandomGenerator() : x(123456789), y(362436000), z(521288629), c(7654321) /* Seed variables */,
+                        stream_seed(STREAM_KEY_SALT) {}
 
+    unsigned int KISS() {
+        unsigned long long t, a = 698769069ULL;
 
-void setUniformDistributionGenerator(int range_from, int range_to, RandVariable indicator){
-    std::default_random_engine generator(time(nullptr));
-    std::uniform_int_distribution<int>  distr(range_from, range_to);
+        x = 69069 * x + 12345;
+        y ^= (y << 13);
+        y ^= (y >> 17);
+        y ^= (y << 5); /* y must never be set to zero! */
+        t = a * z + c;
+        c = (t >> 32); /* Also avoid setting z=c=0! */
 
-    switch (indicator) {
-        case HOT:
-            num_generator_hot = distr;
-            gen_hot = generator;
-        case COLD:
-            num_generator_cold = distr;
-            gen_cold = generator;
-        case COIN_TOSS:
-            num_generator_toss = distr;
-            gen_toss = generator;
+        return x + y + (z = t);
     }
 
-}
+    /* a number in [0, range) (range > 0), without the bias of KISS() % range: Lemire's multiply-shift, where the
+     * few values that would make some results more likely than others are drawn again
+     */
+    unsigned int uniform(unsigned int range) {
+        unsigned int threshold = (0U - range) % range;
+        while (true) {
+            unsigned long long product = (unsigned long long)KISS() * range;
+            if ((unsigned int)product >= threshold) {
+                return (unsigned int)(product >> 32);
+            }
+        }
+    }
 
-/* function for generation a number from one of the uniform engines */
+    /* seed from a random value (the clock and std::random_device), and return it, so the run can be repeated with
+     * seed(value).
+     */
+    unsigned long long seed() {
+        unsigned long long value = ((unsigned long long)std::random_device()() << 32) ^ std::random_device()() ^
+                                   (unsigned long long)time(nullptr);
+        seed(value);
+        return value;
+    }
 
-int getNumber(RandVariable indicator){
-    switch (indicator) {
-        case HOT:
-            return num_generator_hot(gen_hot);
-        case COLD:
-            return num_generator_cold(gen_cold);
-        case COIN_TOSS:
-            return num_generator_toss(gen_toss);
+    /* seed from a value, for reproducible runs. the KISS state is derived from the value with splitmix64 */
+    void seed(unsigned long long value) {
+        stream_seed = value ^ STREAM_KEY_SALT;
+        do {
+            x = splitmix64(&value);
+            y = splitmix64(&value);
+            z = splitmix64(&value);
+            c = splitmix64(&value) % 698769069; /* c must be smaller than the multiplier */
+        } while (y == 0 || z == 0 || c == 0);
     }
-    return -1; // error //
-}
 
-/* generate a uniformly distributed writing sequence of length NUMBER_OF_PAGES.
- * the sequence is generated using the KISS generator, and using mod function to
- * get a logical page number between 0 and LOGICAL_PAGE_NUMBER*PAGES_PER_BLOCK - 1
- */
+    /* the key of a counter based stream of the run (SEQUENCE_STREAM, ...). it only depends on the seed and not on the
+     * KISS state, so generating a writing sequence doesn't change the numbers the rest of the run draws, and a
+     * recorded sequence replayed with the same seed gives the same results as the run that recorded it.
+     */
+    unsigned long long streamKey(unsigned int stream) const {
+        return splitMix(stream_seed + (stream + 1) * SPLITMIX_GAMMA);
+    }
 
-unsigned int* generateUniformlyDistributedWriteSequence(){
-    unsigned int* writing_sequence = new unsigned int[NUMBER_OF_PAGES];
-    for (unsigned long long i = 0; i < NUMBER_OF_PAGES; ++i) {
-        writing_sequence[i] = KISS() % (LOGICAL_BLOCK_NUMBER*PAGES_PER_BLOCK);
+    /* the whole KISS state, to save it to a checkpoint and restore it */
+    void getState(unsigned int state[4]) const {
+        state[0] = x;
+        state[1] = y;
+        state[2] = z;
+        state[3] = c;
+    }
+
+    void setState(const unsigned int state[4]) {
+        x = state[0];
+        y = state[1];
+        z = state[2];
+        c = state[3];
     }
-    return writing_sequence;
-}
 
-/* generate a Hot & Cold pages writing sequence of length NUMBER_OF_PAGES.
- * the sequence is generated using a uniform distribution generator.
- * @param hot_page_percentage is the percentage of hot pages out of total number of logical pages.
- * @p_hot is the probability for a given write to be a hot page write.
- * Note: within each area (Hot/Cold areas) the pages are picked uniformly.
+private:
+    static unsigned int splitmix64(unsigned long long* state) {
+        return (unsigned int)(splitMix(*state += SPLITMIX_GAMMA) >> 32);
+    }
+
+    unsigned int x, y, z, c;
+
+    /* the seed, mixed with STREAM_KEY_SALT. streamKey() is derived from it */
+    unsigned long long stream_seed;
+};
+
+/* a counter based generator: number i of the stream is splitMix(key + (i + 1) * SPLITMIX_GAMMA), which is the
+ * i-th output of a SplitMix64 generator seeded with key. there is no state to carry from one number to the next,
+ * so a batch of numbers is generated 4 or 8 at a time with AVX2 or AVX-512 (picked at run time, all the versions
+ * give the same numbers), and chunks of a stream can be generated in parallel.
  */
+class CounterRandom {
+public:
+    explicit CounterRandom(unsigned long long key = 0) : key(key) {}
 
-unsigned int* generateHotColdWriteSequence(double hot_page_percentage, double p_hot){
-    unsigned int* writing_sequence = new unsigned int[NUMBER_OF_PAGES];
+    unsigned long long at(unsigned long long counter) const {
+        return splitMix(key + (counter + 1) * SPLITMIX_GAMMA);
+    }
 
-    /* set Hot and Cold distribution engines. The selection of pages within every memory area is uniform */
-    setUniformDistributionGenerator(0,(LOGICAL_BLOCK_NUMBER*PAGES_PER_BLOCK)*(double)(hot_page_percentage / 100) , HOT);
-    setUniformDistributionGenerator((LOGICAL_BLOCK_NUMBER*PAGES_PER_BLOCK)*(double)(hot_page_percentage / 100) + 1,(LOGICAL_BLOCK_NUMBER*PAGES_PER_BLOCK) - 1 ,COLD);
+    /* out[i] = a number in [0, range) (range > 0) for the index first + i. a random number has enough bits for two
+     * indices: index 2k is reduced from the high 32 bits of number k, and index 2k + 1 from its low 32 bits (with
+     * Lemire's multiply-shift, and the biased products are drawn again in the same way).
+     */
+    void fillUniform(unsigned int* out, unsigned long long first, unsigned long long count, unsigned int range) const {
+        unsigned int bias = (0U - range) % range;
+        bool biased = false;
+        /* [begin, end) is done by the vector loop, which starts at an even index */
+        unsigned long long begin = 0, end = 0;
+#ifdef COUNTER_RANDOM_SIMD
+        begin = end = count == 0 ? 0 : (first & 1);
+        if (count > begin && simdLevel() == SIMD_AVX512) {
+            end = begin + ((count - begin) & ~15ULL);
+            biased = fillUniformAvx512(out + begin, key + ((first + begin) / 2 + 1) * SPLITMIX_GAMMA, end - begin,
+                                       range, bias);
+        }
+        else if (count > begin && simdLevel() == SIMD_AVX2) {
+            end = begin + ((count - begin) & ~7ULL);
+            biased = fillUniformAvx2(out + begin, key + ((first + begin) / 2 + 1) * SPLITMIX_GAMMA, end - begin,
+                                     range, bias);
+        }
+#endif
+        biased |= fillUniformScalar(out, first, begin, range, bias);
+        biased |= fillUniformScalar(out + end, first + end, count - end, range, bias);
+        if (biased) {
+            for (unsigned long long i = 0; i < count; ++i) {
+                unsigned long long value = at((first + i) >> 1);
+                unsigned int half = (first + i) & 1;
+                unsigned long long product = (half ? value & 0xFFFFFFFFULL : value >> 32) * range;
+                if ((unsigned int)product < bias) {
+                    out[i] = uniform(splitMix(value + (half + 1) * SPLITMIX_GAMMA), range, bias);
+                }
+            }
+        }
+    }
 
-    /* this is a simple uniform distribution variable to represent a coin toss with probability p */
-    setUniformDistributionGenerator(1,10,COIN_TOSS);
+    /* the number in [0, range) of a random value, drawing again from a hash of the value until it isn't biased.
+     * bias is 2^32 mod range
+     */
+    static unsigned int uniform(unsigned long long value, unsigned int range, unsigned int bias) {
+        while (true) {
+            unsigned long long product = (value >> 32) * range;
+            if ((unsigned int)product >= bias) {
+                return (unsigned int)(product >> 32);
+            }
+            value = splitMix(value + SPLITMIX_GAMMA);
+        }
+    }
 
-    for (unsigned int i = 0; i < NUMBER_OF_PAGES; ++i) {
-        int coin_toss = getNumber(COIN_TOSS);
-        if (coin_toss <= p_hot*10){
-            writing_sequence[i] = getNumber(HOT);
+private:
+    /* the loop of fillUniform without vectors. returns true if a number was biased */
+    bool fillUniformScalar(unsigned int* out, unsigned long long first, unsigned long long count, unsigned int range,
+                           unsigned int bias) const {
+        bool biased = false;
+        unsigned long long i = 0;
+        if ((first & 1) && count > 0) {
+            unsigned long long product = (at(first >> 1) & 0xFFFFFFFFULL) * range;
+            out[i++] = (unsigned int)(product >> 32);
+            biased |= (unsigned int)product < bias;
         }
-        else {
-            writing_sequence[i] = getNumber(COLD);
+        for (; i < count; i += 2) {
+            unsigned long long value = at((first + i) >> 1);
+            unsigned long long product = (value >> 32) * range;
+            out[i] = (unsigned int)(product >> 32);
+            biased |= (unsigned int)product < bias;
+            if (i + 1 < count) {
+                product = (value & 0xFFFFFFFFULL) * range;
+                out[i + 1] = (unsigned int)(product >> 32);
+                biased |= (unsigned int)product < bias;
+            }
         }
+        return biased;
     }
-    return writing_sequence;
-}
+
+#ifdef COUNTER_RANDOM_SIMD
+    enum { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+
+    static int simdLevel() {
+        static const int level = [] {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+                return (int)SIMD_AVX512;
+            }
+            return __builtin_cpu_supports("avx2") ? (int)SIMD_AVX2 : (int)SIMD_NONE;
+        }();
+        return level;
+    }
+
+    /* the vector versions of the loop in fillUniform, for count a multiple of twice the vector length. state is
+     * the SplitMix64 state of the first number. returns true if a number was biased
+     */
+    __attribute__((target("avx512f,avx512dq")))
+    static bool fillUniformAvx512(unsigned int* out, unsigned long long state, unsigned long long count,
+                                  unsigned int range, unsigned int bias) {
+        /* the zero masking versions of the shifts, multiplies and conversions are the plain instructions, without
+         * the undefined source operand that some compilers warn about
+         */
+        const __mmask8 all = 0xFF;
+        const __m512i gamma = _mm512_set1_epi64(SPLITMIX_GAMMA);
+        __m512i z = _mm512_add_epi64(_mm512_set1_epi64(state),
+                                     _mm512_mullo_epi64(_mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0), gamma));
+        const __m512i step = _mm512_set1_epi64(8 * SPLITMIX_GAMMA);
+        const __m512i m1 = _mm512_set1_epi64(0xBF58476D1CE4E5B9ULL);
+        const __m512i m2 = _mm512_set1_epi64(0x94D049BB133111EBULL);
+        const __m512i low = _mm512_set1_epi64(0xFFFFFFFFULL);
+        const __m512i ranges = _mm512_set1_epi64(range);
+        const __m512i biases = _mm512_set1_epi64(bias);
+        __mmask8 biased = 0;
+        for (unsigned long long i = 0; i < count; i += 16) {
+            __m512i x = z;
+            z = _mm512_add_epi64(z, step);
+            x = _mm512_mullo_epi64(_mm512_xor_si512(x, _mm512_maskz_srli_epi64(all, x, 30)), m1);
+            x = _mm512_mullo_epi64(_mm512_xor_si512(x, _mm512_maskz_srli_epi64(all, x, 27)), m2);
+            x = _mm512_xor_si512(x, _mm512_maskz_srli_epi64(all, x, 31));
+            __m512i high_product = _mm512_maskz_mul_epu32(all, _mm512_maskz_srli_epi64(all, x, 32), ranges);
+            __m512i low_product = _mm512_maskz_mul_epu32(all, x, ranges);
+            /* the even indices are the high 32 bits of high_product, and the odd ones of low_product */
+            _mm512_storeu_si512(out + i, _mm512_mask_blend_epi32(0xAAAA, _mm512_maskz_srli_epi64(all, high_product, 32),
+                                                                 low_product));
+            biased |= _mm512_cmplt_epu64_mask(_mm512_and_si512(high_product, low), biases) |
+                      _mm512_cmplt_epu64_mask(_mm512_and_si512(low_product, low), biases);
+        }
+        return biased != 0;
+    }
+
+    /* AVX2 has no 64 bit multiply, so x * m is put together from 32 bit multiplies (m_low and m_high are the
+     * halves of m)
+     */
+    __attribute__((target("avx2")))
+    static inline __m256i multiply64Avx2(__m256i x, __m256i m_low, __m256i m_high) {
+        __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), m_low),
+                                         _mm256_mul_epu32(x, m_high));
+        return _mm256_add_epi64(_mm256_mul_epu32(x, m_low), _mm256_slli_epi64(cross, 32));
+    }
+
+    __attribute__((target("avx2")))
+    static bool fillUniformAvx2(unsigned int* out, unsigned long long state, unsigned long long count,
+                                unsigned int range, unsigned int bias) {
+        __m256i z = _mm256_set_epi64x(state + 3 * SPLITMIX_GAMMA, state + 2 * SPLITMIX_GAMMA, state + SPLITMIX_GAMMA,
+                                      state);
+        const __m256i step = _mm256_set1_epi64x(4 * SPLITMIX_GAMMA);
+        const __m256i m1_low = _mm256_set1_epi64x(0x1CE4E5B9ULL), m1_high = _mm256_set1_epi64x(0xBF58476DULL);
+        const __m256i m2_low = _mm256_set1_epi64x(0x133111EBULL), m2_high = _mm256_set1_epi64x(0x94D049BBULL);
+        const __m256i low = _mm256_set1_epi64x(0xFFFFFFFFULL);
+        const __m256i ranges = _mm256_set1_epi64x(range);
+        const __m256i biases = _mm256_set1_epi64x(bias);
+        __m256i biased = _mm256_setzero_si256();
+        for (unsigned long long i = 0; i < count; i += 8) {
+            __m256i x = z;
+            z = _mm256_add_epi64(z, step);
+            x = multiply64Avx2(_mm256_xor_si256(x, _mm256_srli_epi64(x, 30)), m1_low, m1_high);
+            x = multiply64Avx2(_mm256_xor_si256(x, _mm256_srli_epi64(x, 27)), m2_low, m2_high);
+            x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 31));
+            __m256i high_product = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), ranges);
+            __m256i low_product = _mm256_mul_epu32(x, ranges);
+            _mm256_storeu_si256((__m256i*)(out + i),
+                                _mm256_blend_epi32(_mm256_srli_epi64(high_product, 32), low_product, 0xAA));
+            biased = _mm256_or_si256(biased, _mm256_or_si256(
+                    _mm256_cmpgt_epi64(biases, _mm256_and_si256(high_product, low)),
+                    _mm256_cmpgt_epi64(biases, _mm256_and_si256(low_product, low))));
+        }
+        return !_mm256_testz_si256(biased, biased);
+    }
+#endif
+
+    unsigned long long key;
+};
 
 #endif /* MYRAND_H_ */
@@ -0,0 +1,80 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	Profile holds the wall-clock time of the phases of a simulation (see Phase) and the work counters of the
+ *	victim selection, for the JSON run report (see AlgoRunner::writeReport). a phase is timed by a ScopedTimer
+ *	around it, which does nothing when it is given no profile, so the timers inside the FTL (victim selection and
+ *	relocation, taken on every erase) only cost a branch unless profiling was turned on.
+ *	phases may be nested: the simulation phase includes the victim selection, the relocation and (in streaming
+ *	mode) the sequence generation of the writes it does.
+ */
+
+#ifndef FLASHGC_PROFILE_H
+#define FLASHGC_PROFILE_H
+
+#include <atomic>
+#include <chrono>
+#include "Auxilaries.h"
+
+class Profile {
+public:
+    /* per phase: the total time in nanoseconds, and the number of times it was timed */
+    unsigned long long phase_ns[NUMBER_OF_PHASES];
+    unsigned long long phase_calls[NUMBER_OF_PHASES];
+
+    /* exact block scores computed (score cache hits are not counted), and the pages (or, without a closed form
+     * scorer, the writes of the sequence) getBlockScore went over to compute them. blocks may be scored on the
+     * threads of a pool, so these are atomic.
+     */
+    std::atomic<unsigned long long> blocks_scored;
+    std::atomic<unsigned long long> pages_scanned;
+
+    Profile() : phase_ns(), phase_calls(), blocks_scored(0), pages_scanned(0) {}
+
+    Profile(const Profile&) = delete;
+    Profile& operator=(const Profile&) = delete;
+
+    void add(Phase phase, unsigned long long ns) {
+        phase_ns[phase] += ns;
+        phase_calls[phase]++;
+    }
+
+    double seconds(Phase phase) const {
+        return phase_ns[phase] / 1e9;
+    }
+
+    void countScore(unsigned long long pages) {
+        blocks_scored.fetch_add(1, std::memory_order_relaxed);
+        pages_scanned.fetch_add(pages, std::memory_order_relaxed);
+    }
+};
+
+/* adds the time from its construction to its destruction to a phase of profile (if not nullptr) */
+class ScopedTimer {
+public:
+    ScopedTimer(Profile* profile, Phase phase) : profile(profile), phase(phase) {
+        if (profile) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTimer() {
+        if (profile) {
+            profile->add(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Profile* profile;
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif //FLASHGC_PROFILE_H
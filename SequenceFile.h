@@ -0,0 +1,432 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	A sequence file is a compact binary recording of a writing sequence, so a canonical workload (a generated
+ *	sequence or a converted block I/O trace) can be archived and replayed without generating or parsing it again.
+ *
+ *	Layout (all the fields are in the byte order of the machine that wrote the file, little endian on x86/ARM):
+ *	SequenceFileHeader - the geometry, the sequence length, the seed and the distribution it was recorded with.
+ *	blocks             - the sequence, in blocks of block_length writes (the last block may be shorter). a block
+ *	                     starts with its encoding byte, and the writer picks the smaller encoding for every block:
+ *	                     PACKED_BLOCK - a width byte, then every logical page in width bits (least significant
+ *	                                    bit first). good for random sequences.
+ *	                     DELTA_BLOCK  - the difference from the previous page of the block (the first page is
+ *	                                    taken from 0), zigzag encoded into a varint of 7 bits per byte. good for
+ *	                                    sequential runs (traces).
+ *	block index        - number_of_blocks + 1 file offsets: the start of every block, and the end of the last
+ *	                     one. any write of the sequence can be found by decoding one block.
+ *
+ *	The reader maps the file and decodes the blocks on demand, straight into the buffer of the simulation when a
+ *	whole block fits in it.
+ */
+
+#ifndef FLASHGC_SEQUENCEFILE_H
+#define FLASHGC_SEQUENCEFILE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "Auxilaries.h"
+#include "SequenceSource.h"
+
+#define SEQUENCE_FILE_MAGIC "FGCSEQ1"
+#define SEQUENCE_FILE_VERSION 1
+#define DEFAULT_SEQUENCE_BLOCK 65536
+
+/* SequenceFileHeader flags: the sequence was generated from a known seed */
+#define SEQUENCE_FILE_HAS_SEED 1
+
+#define PACKED_BLOCK 0
+#define DELTA_BLOCK 1
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+class SequenceFileHeader {
+public:
+    char magic[8];
+    uint32_t version;
+    /* number of writes in every block (but the last one) */
+    uint32_t block_length;
+
+    /* the geometry the sequence was recorded with. only the logical pages (U*Z) must match on replay */
+    uint32_t physical_blocks;
+    uint32_t logical_blocks;
+    uint32_t pages_per_block;
+    uint32_t page_size;
+    uint64_t number_of_pages;
+
+    /* the seed of the sequence, if flags has SEQUENCE_FILE_HAS_SEED */
+    uint64_t seed;
+    uint32_t flags;
+
+    /* the PageDistribution the sequence was generated with, and its hot/cold parameters */
+    uint32_t distribution;
+    uint32_t hot_pages_percentage;
+    uint32_t reserved;
+    double hot_pages_probability;
+
+    uint64_t number_of_blocks;
+    uint64_t index_offset;
+
+    SequenceFileHeader() :
+            version(SEQUENCE_FILE_VERSION), block_length(DEFAULT_SEQUENCE_BLOCK), physical_blocks(0), logical_blocks(0),
+            pages_per_block(0), page_size(0), number_of_pages(0), seed(0), flags(0), distribution(0),
+            hot_pages_percentage(0), reserved(0), hot_pages_probability(0), number_of_blocks(0), index_offset(0) {
+        memcpy(magic, SEQUENCE_FILE_MAGIC, sizeof(magic));
+    }
+
+    SequenceFileHeader(const SimConfig& config, PageDistribution distribution) : SequenceFileHeader() {
+        physical_blocks = config.physical_blocks;
+        logical_blocks = config.logical_blocks;
+        pages_per_block = config.pages_per_block;
+        page_size = config.page_size;
+        this->distribution = distribution;
+    }
+
+    unsigned long long logicalPages() const {
+        return (unsigned long long)logical_blocks * pages_per_block;
+    }
+};
+
+/* the header is written as is, so its layout must not depend on the compiler */
+static_assert(sizeof(SequenceFileHeader) == 88, "SequenceFileHeader must not have padding");
+
+class SequenceFileWriter {
+public:
+    /* create path (or truncate it). header gives everything but the sequence length and the blocks */
+    SequenceFileWriter(const char* path, const SequenceFileHeader& header) : header(header), path(path) {
+        file = fopen(path, "wb");
+        if (!file) {
+            cerr << "Error! Could not create sequence file " << path << "." << endl;
+            exit(-1);
+        }
+        this->header.number_of_pages = 0;
+        this->header.number_of_blocks = 0;
+        block.reserve(header.block_length);
+        offset = 0;
+        write(&this->header, sizeof(SequenceFileHeader));
+    }
+
+    ~SequenceFileWriter() {
+        if (file) {
+            close();
+        }
+    }
+
+    SequenceFileWriter(const SequenceFileWriter&) = delete;
+    SequenceFileWriter& operator=(const SequenceFileWriter&) = delete;
+
+    void append(const unsigned int* pages, unsigned long long count) {
+        for (unsigned long long i = 0; i < count; ++i) {
+            block.push_back(pages[i]);
+            if (block.size() == header.block_length) {
+                writeBlock();
+            }
+        }
+        header.number_of_pages += count;
+    }
+
+    /* write the last block, the block index and the final header. returns the size of the file */
+    unsigned long long close() {
+        if (!block.empty()) {
+            writeBlock();
+        }
+        header.index_offset = offset;
+        block_offsets.push_back(offset);
+        write(block_offsets.data(), block_offsets.size() * sizeof(uint64_t));
+        header.number_of_blocks = block_offsets.size() - 1;
+        unsigned long long file_size = offset;
+        if (fseek(file, 0, SEEK_SET) != 0) {
+            fail();
+        }
+        write(&header, sizeof(SequenceFileHeader));
+        if (fclose(file) != 0) {
+            file = nullptr;
+            fail();
+        }
+        file = nullptr;
+        return file_size;
+    }
+
+private:
+    void writeBlock() {
+        block_offsets.push_back(offset);
+
+        uint32_t max_page = 0;
+        for (unsigned int page : block) {
+            max_page = page > max_page ? page : max_page;
+        }
+        unsigned char width = 0;
+        while (width < 32 && (max_page >> width) != 0) {
+            width++;
+        }
+        unsigned long long packed_size = 2 + (block.size() * width + 7) / 8;
+
+        encoded.clear();
+        encoded.push_back(DELTA_BLOCK);
+        long long previous = 0;
+        for (unsigned int page : block) {
+            long long delta = (long long)page - previous;
+            unsigned long long value = ((unsigned long long)delta << 1) ^ (unsigned long long)(delta >> 63);
+            while (value >= 0x80) {
+                encoded.push_back((unsigned char)(value | 0x80));
+                value >>= 7;
+            }
+            encoded.push_back((unsigned char)value);
+            previous = page;
+        }
+
+        if (packed_size <= encoded.size()) {
+            encoded.clear();
+            encoded.push_back(PACKED_BLOCK);
+            encoded.push_back(width);
+            /* at most 7 + 32 bits are pending at a time */
+            unsigned long long bits = 0;
+            unsigned int pending = 0;
+            for (unsigned int page : block) {
+                bits |= (unsigned long long)page << pending;
+                pending += width;
+                while (pending >= 8) {
+                    encoded.push_back((unsigned char)bits);
+                    bits >>= 8;
+                    pending -= 8;
+                }
+            }
+            if (pending > 0) {
+                encoded.push_back((unsigned char)bits);
+            }
+        }
+
+        write(encoded.data(), encoded.size());
+        block.clear();
+    }
+
+    void write(const void* buffer, size_t size) {
+        if (fwrite(buffer, 1, size, file) != size) {
+            fail();
+        }
+        offset += size;
+    }
+
+    void fail() {
+        cerr << "Error! Could not write sequence file " << path << "." << endl;
+        exit(-1);
+    }
+
+    SequenceFileHeader header;
+    const char* path;
+    FILE* file;
+    unsigned long long offset;
+    vector<unsigned int> block;
+    vector<unsigned char> encoded;
+    vector<uint64_t> block_offsets;
+};
+
+/* replays a sequence file. if the sequence is longer than the file, the file is replayed again from the start */
+class SequenceFileSource : public SequenceSource {
+public:
+    SequenceFileSource(const SimConfig& config, const char* path) :
+            next_block(0), decoded_length(0), position(0), replayed(0) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            cerr << "Error! Could not open sequence file " << path << "." << endl;
+            exit(-1);
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || (unsigned long long)file_stat.st_size < sizeof(SequenceFileHeader)) {
+            cerr << "Error! " << path << " is not a sequence file." << endl;
+            exit(-1);
+        }
+        mapped_size = file_stat.st_size;
+        void* mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            cerr << "Error! Could not map sequence file " << path << "." << endl;
+            exit(-1);
+        }
+        begin = (const unsigned char*)mapped;
+        memcpy(&file_header, begin, sizeof(SequenceFileHeader));
+
+        if (memcmp(file_header.magic, SEQUENCE_FILE_MAGIC, sizeof(file_header.magic)) != 0 ||
+            file_header.version != SEQUENCE_FILE_VERSION) {
+            cerr << "Error! " << path << " is not a sequence file (or was written by another version)." << endl;
+            exit(-1);
+        }
+        if (file_header.logicalPages() != config.logicalPages()) {
+            cerr << "Error! Sequence file " << path << " was recorded with U*Z = " << file_header.logicalPages()
+                 << " logical pages, and the simulation has " << config.logicalPages() << "." << endl;
+            exit(-1);
+        }
+        if (file_header.number_of_pages == 0 || file_header.block_length == 0 ||
+            file_header.number_of_blocks != (file_header.number_of_pages + file_header.block_length - 1) /
+                                            file_header.block_length ||
+            file_header.index_offset > mapped_size ||
+            (mapped_size - file_header.index_offset) / sizeof(uint64_t) < file_header.number_of_blocks + 1) {
+            cerr << "Error! Sequence file " << path << " is truncated or corrupted." << endl;
+            exit(-1);
+        }
+        index = begin + file_header.index_offset;
+        for (unsigned long long i = 0; i < file_header.number_of_blocks; ++i) {
+            /* a block has at least its encoding byte (and a width byte if packed) */
+            uint64_t block_begin = blockOffset(i), block_end = blockOffset(i + 1);
+            if (block_begin < sizeof(SequenceFileHeader) || block_end <= block_begin ||
+                block_end > file_header.index_offset) {
+                cerr << "Error! Sequence file " << path << " is truncated or corrupted." << endl;
+                exit(-1);
+            }
+        }
+        block_buffer.resize(file_header.block_length);
+    }
+
+    ~SequenceFileSource() override {
+        munmap((void*)begin, mapped_size);
+    }
+
+    SequenceFileSource(const SequenceFileSource&) = delete;
+    SequenceFileSource& operator=(const SequenceFileSource&) = delete;
+
+    const SequenceFileHeader& header() const {
+        return file_header;
+    }
+
+    void fill(unsigned int* buffer, unsigned long long count) override {
+        replayed += count;
+        unsigned long long i = 0;
+        while (i < count) {
+            if (position < decoded_length) {
+                unsigned long long n = decoded_length - position < count - i ? decoded_length - position : count - i;
+                memcpy(buffer + i, block_buffer.data() + position, n * sizeof(unsigned int));
+                position += n;
+                i += n;
+                continue;
+            }
+            if (next_block == file_header.number_of_blocks) {
+                /* replay the file from the start */
+                next_block = 0;
+            }
+            unsigned long long length = blockLength(next_block);
+            if (count - i >= length) {
+                decodeBlock(next_block++, buffer + i);
+                i += length;
+            }
+            else {
+                decodeBlock(next_block, block_buffer.data());
+                decoded_length = length;
+                position = 0;
+                next_block++;
+            }
+        }
+    }
+
+    /* continue the sequence from write number write_index (taken modulo the length of the file) */
+    void seek(unsigned long long write_index) {
+        write_index %= file_header.number_of_pages;
+        unsigned long long block_number = write_index / file_header.block_length;
+        decodeBlock(block_number, block_buffer.data());
+        decoded_length = blockLength(block_number);
+        position = write_index % file_header.block_length;
+        next_block = block_number + 1;
+    }
+
+    void skip(unsigned long long count) override {
+        replayed += count;
+        seek(replayed);
+    }
+
+private:
+    /* the file offset of a block from the block index. the index follows the last block, so it may be unaligned */
+    uint64_t blockOffset(unsigned long long block_number) const {
+        uint64_t offset;
+        memcpy(&offset, index + block_number * sizeof(uint64_t), sizeof(offset));
+        return offset;
+    }
+
+    unsigned long long blockLength(unsigned long long block_number) const {
+        if (block_number + 1 < file_header.number_of_blocks) {
+            return file_header.block_length;
+        }
+        return file_header.number_of_pages - block_number * file_header.block_length;
+    }
+
+    void decodeBlock(unsigned long long block_number, unsigned int* out) const {
+        const unsigned char* p = begin + blockOffset(block_number);
+        const unsigned char* block_end = begin + blockOffset(block_number + 1);
+        unsigned long long length = blockLength(block_number);
+        if (*p == PACKED_BLOCK) {
+            unsigned int width = p[1];
+            const unsigned char* packed = p + 2;
+            if (width > 32 || (length * width + 7) / 8 > (unsigned long long)(block_end - packed)) {
+                corrupted();
+            }
+            if (width == 0) {
+                memset(out, 0, length * sizeof(unsigned int));
+                return;
+            }
+            unsigned long long mask = (1ULL << width) - 1;
+            for (unsigned long long i = 0, bit = 0; i < length; ++i, bit += width) {
+                /* the block index follows the last block, so there are always 8 bytes to load */
+                unsigned long long word;
+                memcpy(&word, packed + (bit >> 3), sizeof(word));
+                out[i] = (unsigned int)((word >> (bit & 7)) & mask);
+            }
+        }
+        else if (*p == DELTA_BLOCK) {
+            p++;
+            long long page = 0;
+            for (unsigned long long i = 0; i < length; ++i) {
+                unsigned long long value = 0;
+                int shift = 0;
+                while (true) {
+                    if (p == block_end || shift > 35) {
+                        corrupted();
+                    }
+                    unsigned char byte = *p++;
+                    value |= (unsigned long long)(byte & 0x7F) << shift;
+                    if (byte < 0x80) {
+                        break;
+                    }
+                    shift += 7;
+                }
+                page += (long long)(value >> 1) ^ -(long long)(value & 1);
+                out[i] = (unsigned int)page;
+            }
+        }
+        else {
+            corrupted();
+        }
+    }
+
+    [[noreturn]] static void corrupted() {
+        cerr << "Error! The sequence file is corrupted." << endl;
+        exit(-1);
+    }
+
+    SequenceFileHeader file_header;
+    const unsigned char* begin;
+    size_t mapped_size;
+    const unsigned char* index;
+
+    /* the next block to decode, and the block that was decoded into block_buffer when fill needed only a part
+     * of it (decoded_length writes, of which position were already given)
+     */
+    unsigned long long next_block;
+    vector<unsigned int> block_buffer;
+    unsigned long long decoded_length;
+    unsigned long long position;
+
+    /* the number of writes given (or skipped) so far */
+    unsigned long long replayed;
+};
+
+#endif //FLASHGC_SEQUENCEFILE_H
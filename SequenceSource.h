@@ -0,0 +1,103 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	A SequenceSource generates a writing sequence chunk by chunk, so the sequence doesn't have to be kept in
+ *	memory as a whole (see SequenceStream). the generate*WriteSequence functions below fill a whole array from
+ *	the same sources, so a streamed sequence is identical to the in-memory sequence generated from the same
+ *	random state.
+ *	The generated sources draw a key from the random state when they are created, and write i of the sequence
+ *	is a function of the key and i (see CounterRandom). so the sequence doesn't depend on the chunk sizes, and
+ *	an in-memory sequence can be generated by several threads.
+ */
+
+#ifndef FLASHGC_SEQUENCESOURCE_H
+#define FLASHGC_SEQUENCESOURCE_H
+
+#include "MyRand.h"
+#include "SimConfig.h"
+#include "ThreadPool.h"
+
+/* the number of writes SequenceSource::skip generates at once */
+#define SKIP_CHUNK 4096
+
+class SequenceSource {
+public:
+    virtual ~SequenceSource() {}
+
+    /* write the next count logical page numbers of the sequence to buffer */
+    virtual void fill(unsigned int* buffer, unsigned long long count) = 0;
+
+    /* skip the next count logical page numbers of the sequence. by default they are generated and dropped */
+    virtual void skip(unsigned long long count) {
+        unsigned int buffer[SKIP_CHUNK];
+        while (count > 0) {
+            unsigned long long n = count < SKIP_CHUNK ? count : SKIP_CHUNK;
+            fill(buffer, n);
+            count -= n;
+        }
+    }
+};
+
+class GeneratedSequenceSource : public SequenceSource {
+public:
+    void fill(unsigned int* buffer, unsigned long long count) override {
+        fillAt(buffer, position, count);
+        position += count;
+    }
+
+    void skip(unsigned long long count) override {
+        position += count;
+    }
+
+    /* write the logical page numbers of writes first..first+count-1 to buffer. may be called from several threads
+     * at once
+     */
+    virtual void fillAt(unsigned int* buffer, unsigned long long first, unsigned long long count) const = 0;
+
+protected:
+    explicit GeneratedSequenceSource(RandomGenerator* rng) : random(rng->streamKey(SEQUENCE_STREAM)), position(0) {}
+
+    CounterRandom random;
+
+    /* the next write that fill gives */
+    unsigned long long position;
+};
+
+/* every write is a logical page number between 0 and U*Z - 1, picked uniformly */
+class UniformSequenceSource : public GeneratedSequenceSource {
+public:
+    UniformSequenceSource(const SimConfig& config, RandomGenerator* rng) :
+            GeneratedSequenceSource(rng), logical_pages(config.logicalPages()) {}
+
+    void fillAt(unsigned int* buffer, unsigned long long first, unsigned long long count) const override {
+        random.fillUniform(buffer, first, count, logical_pages);
+    }
+
+private:
+    unsigned int logical_pages;
+};
+
+/* fill a whole writing sequence of length N from source, splitting it between the threads of pool (if given) */
+unsigned int* generateWriteSequence(const SimConfig& config, const GeneratedSequenceSource& source, ThreadPool* pool){
+    unsigned int* writing_sequence = new unsigned int[config.number_of_pages];
+    if (pool){
+        pool->parallelFor(config.number_of_pages, [writing_sequence, &source](size_t begin, size_t end) {
+            source.fillAt(writing_sequence + begin, begin, end - begin);
+        });
+    }
+    else {
+        source.fillAt(writing_sequence, 0, config.number_of_pages);
+    }
+    return writing_sequence;
+}
+
+/* generate a uniformly distributed writing sequence of length N */
+unsigned int* generateUniformlyDistributedWriteSequence(const SimConfig& config, RandomGenerator* rng,
+                                                        ThreadPool* pool = nullptr){
+    return generateWriteSequence(config, UniformSequenceSource(config, rng), pool);
+}
+
+#endif //FLASHGC_SEQUENCESOURCE_H
@@ -0,0 +1,214 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	SequenceStream replaces the in-memory writing sequence for long simulations. the sequence is generated in fixed
+ *	size chunks into a ring buffer, which only holds the writes from the current one up to the lookahead horizon
+ *	the algorithm needs: Z*T future writes for the block score of the Look Ahead algorithms (and the page score of
+ *	the generational algorithm), and none for greedy. so the memory of the simulation doesn't depend on N.
+ *	the writes must be read in order, and a write is valid until the next one is read.
+ *	In pipelined mode (see startPipeline) the chunks are generated on a producer thread, so the generation of the
+ *	sequence overlaps with the simulation. the producer fills a fixed set of chunk buffers and passes them to the
+ *	simulation thread through a lock-free queue, and the simulation copies them into the ring buffer and passes them
+ *	back through a second queue. the chunks are generated by the same source in the same order, so the sequence is
+ *	the same as without the pipeline.
+ */
+
+#ifndef FLASHGC_SEQUENCESTREAM_H
+#define FLASHGC_SEQUENCESTREAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "SequenceSource.h"
+#include "LookaheadScorer.h"
+#include "Profile.h"
+#include "SpscQueue.h"
+
+#define DEFAULT_STREAM_CHUNK 65536
+
+/* the number of chunk buffers of a pipelined stream, i.e. how far the producer may run ahead of the simulation */
+#define PIPELINE_CHUNKS 4
+
+using std::vector;
+
+class SequenceStream {
+public:
+
+    /* @param source generates the sequence, and is owned by the stream.
+     * @param length the length of the sequence (N).
+     * @param horizon the number of writes after the current one that must be generated before it is read.
+     * @param chunk_size the number of writes generated at once.
+     */
+    SequenceStream(SequenceSource* source, unsigned long long length, unsigned long long horizon,
+                   unsigned int chunk_size) :
+            source(source), scorer(nullptr), profile(nullptr), length(length), horizon(horizon),
+            chunk_size(chunk_size > 0 ? chunk_size : DEFAULT_STREAM_CHUNK), first_write(0), produced(0),
+            pipelined(false), full_chunks(nullptr), free_chunks(nullptr), stop_producer(false) {
+        /* when a chunk is generated for write i we have produced <= i + horizon, so the buffer must hold
+         * horizon + chunk_size + 1 writes from i on
+         */
+        unsigned long long capacity = 1;
+        while (capacity < horizon + this->chunk_size + 1) {
+            capacity *= 2;
+        }
+        buffer.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    ~SequenceStream() {
+        if (producer.joinable()) {
+            stop_producer.store(true, std::memory_order_relaxed);
+            producer.join();
+        }
+        delete full_chunks;
+        delete free_chunks;
+        delete source;
+    }
+
+    SequenceStream(const SequenceStream&) = delete;
+    SequenceStream& operator=(const SequenceStream&) = delete;
+
+    unsigned long long capacity() const {
+        return buffer.size();
+    }
+
+    /* the scorer is given every write once it is generated (see LookaheadScorer::append) */
+    void setScorer(LookaheadScorer* scorer) {
+        this->scorer = scorer;
+    }
+
+    /* the time it takes to generate the chunks (or, in pipelined mode, to take them from the producer) is added to
+     * the sequence generation phase of profile
+     */
+    void setProfile(Profile* profile) {
+        this->profile = profile;
+    }
+
+    /* generate the rest of the sequence on a producer thread. must be called before the first write is read.
+     * the producer thread starts when the first write is read, and from then on the source is only used by it.
+     */
+    void startPipeline() {
+        if (produced == first_write) {
+            pipelined = true;
+        }
+    }
+
+    /* start the sequence at write index instead of its first write (when a simulation is resumed from a
+     * checkpoint). must be called before the first write is read.
+     */
+    void skipTo(unsigned long long index) {
+        if (produced != first_write || index < produced) {
+            return;
+        }
+        source->skip(index - produced);
+        first_write = produced = index;
+        if (scorer) {
+            scorer->startAt(index);
+        }
+    }
+
+    /* the logical page number of the index-th write. indexes must not go backwards */
+    unsigned int at(unsigned long long index) {
+        while (produced < length && produced <= index + horizon) {
+            produceChunk();
+        }
+        return buffer[index & mask];
+    }
+
+private:
+    class Chunk {
+    public:
+        vector<unsigned int> pages;
+    };
+
+    void launchProducer() {
+        chunks.resize(PIPELINE_CHUNKS);
+        full_chunks = new SpscQueue<Chunk*>(PIPELINE_CHUNKS);
+        free_chunks = new SpscQueue<Chunk*>(PIPELINE_CHUNKS);
+        for (Chunk& chunk : chunks) {
+            chunk.pages.resize(chunk_size);
+            free_chunks->push(&chunk);
+        }
+        producer = std::thread(&SequenceStream::producerLoop, this);
+    }
+
+    void produceChunk() {
+        ScopedTimer timer(profile, SEQUENCE_PHASE);
+        if (pipelined && !producer.joinable()) {
+            launchProducer();
+        }
+        unsigned long long count = length - produced < chunk_size ? length - produced : chunk_size;
+        /* the chunk may wrap around the end of the buffer */
+        unsigned long long start = produced & mask;
+        unsigned long long first_part = buffer.size() - start < count ? buffer.size() - start : count;
+        if (producer.joinable()) {
+            Chunk* chunk;
+            while (!full_chunks->pop(&chunk)) {
+                std::this_thread::yield();
+            }
+            std::copy(chunk->pages.begin(), chunk->pages.begin() + first_part, buffer.begin() + start);
+            std::copy(chunk->pages.begin() + first_part, chunk->pages.begin() + count, buffer.begin());
+            free_chunks->push(chunk);
+        }
+        else {
+            source->fill(buffer.data() + start, first_part);
+            source->fill(buffer.data(), count - first_part);
+        }
+        if (scorer) {
+            for (unsigned long long i = produced; i < produced + count; i++) {
+                scorer->append(i, buffer[i & mask]);
+            }
+        }
+        produced += count;
+    }
+
+    /* generate the chunks in order into free chunk buffers until the whole sequence was generated */
+    void producerLoop() {
+        for (unsigned long long generated = first_write; generated < length;) {
+            Chunk* chunk;
+            while (!free_chunks->pop(&chunk)) {
+                if (stop_producer.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            unsigned long long count = length - generated < chunk_size ? length - generated : chunk_size;
+            source->fill(chunk->pages.data(), count);
+            generated += count;
+            /* the chunks are in one of the queues, so there is always room */
+            full_chunks->push(chunk);
+        }
+    }
+
+    SequenceSource* source;
+    LookaheadScorer* scorer;
+    Profile* profile;
+    unsigned long long length;
+    unsigned long long horizon;
+    unsigned int chunk_size;
+
+    /* the write the stream starts at (0 unless it was skipped to another one), and the number of writes
+     * generated so far (counting the skipped ones)
+     */
+    unsigned long long first_write;
+    unsigned long long produced;
+    bool pipelined;
+
+    vector<unsigned int> buffer;
+    unsigned long long mask;
+
+    /* pipelined mode only: the chunk buffers, which are either in full_chunks (generated and not copied to the
+     * ring buffer yet) or in free_chunks (ready to be generated into)
+     */
+    vector<Chunk> chunks;
+    SpscQueue<Chunk*>* full_chunks;
+    SpscQueue<Chunk*>* free_chunks;
+    std::atomic<bool> stop_producer;
+    std::thread producer;
+};
+
+#endif //FLASHGC_SEQUENCESTREAM_H
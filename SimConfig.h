@@ -0,0 +1,50 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	SimConfig holds the geometry of the simulated memory and the length of the simulation. every simulation
+ *	object (FTL, AlgoRunner, the writing sequence generators) gets its own copy, so several simulations with
+ *	different geometries can live in one process.
+ */
+
+#ifndef FLASHGC_SIMCONFIG_H
+#define FLASHGC_SIMCONFIG_H
+
+class SimConfig {
+public:
+    /* number of physical blocks (T) */
+    int physical_blocks;
+
+    /* number of logical blocks (U) */
+    int logical_blocks;
+
+    /* number of pages per block (Z) */
+    int pages_per_block;
+
+    /* number of bytes per page */
+    int page_size;
+
+    /* length of the writing sequence (N) */
+    unsigned long long number_of_pages;
+
+    SimConfig() : physical_blocks(0), logical_blocks(0), pages_per_block(0), page_size(0), number_of_pages(0) {}
+
+    SimConfig(int physical_blocks, int logical_blocks, int pages_per_block, int page_size,
+              unsigned long long number_of_pages) :
+            physical_blocks(physical_blocks), logical_blocks(logical_blocks), pages_per_block(pages_per_block),
+            page_size(page_size), number_of_pages(number_of_pages) {}
+
+    /* number of logical pages (U*Z) */
+    unsigned int logicalPages() const {
+        return (unsigned int)logical_blocks * pages_per_block;
+    }
+
+    /* number of physical pages (T*Z) */
+    unsigned long long physicalPages() const {
+        return (unsigned long long)physical_blocks * pages_per_block;
+    }
+};
+
+#endif //FLASHGC_SIMCONFIG_H
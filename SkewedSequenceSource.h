@@ -0,0 +1,330 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	Skewed writing sequences. a SkewedSequenceSource splits the logical pages into areas of consecutive pages with
+ *	weights: every write picks an area with a probability proportional to its weight, and a page uniformly within
+ *	the area. the area is picked in O(1) with Vose's alias method (see AliasTable), so a write costs the same with
+ *	two areas or with an area per page, and the distributions only differ in the areas they build:
+ *	hot_cold - the hot pages with probability p_hot, and the rest of the pages.
+ *	tiers - any number of tiers (e.g. hot, warm and cold), each a percentage of the pages with a probability.
+ *	zipf - an area per page, where page r (0 is the hottest) has weight 1/(r+1)^theta.
+ *	ycsb - YCSB's scrambled zipfian: zipf over the pages in a random order, so the hot pages are spread over the
+ *	logical space.
+ *	tpcc - TPC-C's non uniform random NURand(A, 0, U*Z-1), with the exact probability of every page.
+ *	write i takes numbers 2i and 2i+1 of the counter based generator (one for the area and one for the page within
+ *	the area), so like the other generated sources it only depends on the key and on i.
+ */
+
+#ifndef FLASHGC_SKEWEDSEQUENCESOURCE_H
+#define FLASHGC_SKEWEDSEQUENCESOURCE_H
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <vector>
+#include "SequenceSource.h"
+
+using std::vector;
+
+/* the default theta of the zipf and ycsb distributions (the zipfian constant of YCSB) */
+#define DEFAULT_ZIPF_THETA 0.99
+
+/* a tier of the tiers distribution */
+class Tier {
+public:
+    /* percentage of the logical pages in the tier */
+    double page_percentage;
+    /* probability of a write to be in the tier */
+    double probability;
+};
+
+/* the parameters of the skewed distributions (other than hot_cold, which asks for its parameters) */
+class SkewOptions {
+public:
+    /* zipf and ycsb only */
+    double zipf_theta;
+    /* tiers only: the tiers from the first (pages 0..) to the last */
+    vector<Tier> tiers;
+
+    SkewOptions() : zipf_theta(DEFAULT_ZIPF_THETA) {}
+};
+
+/* Vose's alias method: n weights are turned into n columns of the same probability. column i gives i with
+ * probability threshold/2^32 and its alias otherwise, so an index is picked with one uniform column and one coin
+ * toss, whatever the weights are. the table is built in O(n).
+ */
+class AliasTable {
+public:
+    AliasTable() : size(0), bias(0) {}
+
+    /* the weights must not be negative, and at least one of them must be positive */
+    explicit AliasTable(const vector<double>& weights) : columns(weights.size()), size(weights.size()) {
+        double total = 0;
+        for (double weight : weights) {
+            total += weight;
+        }
+        /* the weights in column units (the average weight is 1) */
+        vector<double> scaled(size);
+        vector<unsigned int> small, large;
+        for (unsigned int i = 0; i < size; i++) {
+            scaled[i] = weights[i] * size / total;
+            if (scaled[i] < 1) {
+                small.push_back(i);
+            }
+            else {
+                large.push_back(i);
+            }
+        }
+        /* the column of a small index is filled up by a large index, which is left with less weight */
+        while (!small.empty() && !large.empty()) {
+            unsigned int index = small.back();
+            small.pop_back();
+            unsigned int alias = large.back();
+            columns[index].threshold = (unsigned int)std::min(scaled[index] * 4294967296.0, 4294967295.0);
+            columns[index].alias = alias;
+            scaled[alias] -= 1 - scaled[index];
+            if (scaled[alias] < 1) {
+                large.pop_back();
+                small.push_back(alias);
+            }
+        }
+        /* what is left has a whole column (up to rounding errors) */
+        for (unsigned int index : large) {
+            columns[index].threshold = 0xFFFFFFFFU;
+            columns[index].alias = index;
+        }
+        for (unsigned int index : small) {
+            columns[index].threshold = 0xFFFFFFFFU;
+            columns[index].alias = index;
+        }
+        bias = (0U - size) % size;
+    }
+
+    /* the index of a 64 bit random value. the column is reduced from the high 32 bits (and drawn again from a hash
+     * of the value if the product is biased, like in CounterRandom::uniform), and the coin is the low 32 bits.
+     */
+    unsigned int sample(unsigned long long value) const {
+        unsigned long long product = (value >> 32) * size;
+        while ((unsigned int)product < bias) {
+            value = splitMix(value + SPLITMIX_GAMMA);
+            product = (value >> 32) * size;
+        }
+        const Column& column = columns[product >> 32];
+        return (unsigned int)value < column.threshold ? (unsigned int)(product >> 32) : column.alias;
+    }
+
+private:
+    class Column {
+    public:
+        unsigned int threshold;
+        unsigned int alias;
+    };
+
+    vector<Column> columns;
+    unsigned int size;
+    /* 2^32 mod size */
+    unsigned int bias;
+};
+
+class SkewedSequenceSource : public GeneratedSequenceSource {
+public:
+    void fillAt(unsigned int* buffer, unsigned long long first, unsigned long long count) const override {
+        for (unsigned long long i = 0; i < count; i++) {
+            unsigned long long write = first + i;
+            unsigned int index = table.sample(random.at(2 * write));
+            if (areas.empty()) {
+                buffer[i] = index;
+                continue;
+            }
+            const Area& area = areas[index];
+            buffer[i] = area.first_page;
+            if (area.pages > 1) {
+                buffer[i] += CounterRandom::uniform(random.at(2 * write + 1), area.pages, area.bias);
+            }
+        }
+    }
+
+protected:
+    explicit SkewedSequenceSource(RandomGenerator* rng) : GeneratedSequenceSource(rng) {}
+
+    /* pages first_page..first_page+pages-1 */
+    class Area {
+    public:
+        unsigned int first_page;
+        unsigned int pages;
+        /* 2^32 mod pages */
+        unsigned int bias;
+    };
+
+    void addArea(unsigned int first_page, unsigned int pages, double weight) {
+        areas.push_back(Area{first_page, pages, (0U - pages) % pages});
+        weights.push_back(weight);
+    }
+
+    /* build the alias table of the areas that were added */
+    void buildAreas() {
+        table = AliasTable(weights);
+        weights.clear();
+    }
+
+    /* an area per page: write i is page j with probability page_weights[j] / (the sum of the weights) */
+    void buildPages(const vector<double>& page_weights) {
+        areas.clear();
+        table = AliasTable(page_weights);
+    }
+
+private:
+    /* empty if every page is an area */
+    vector<Area> areas;
+    vector<double> weights;
+    AliasTable table;
+};
+
+/* @param hot_page_percentage is the percentage of hot pages out of total number of logical pages.
+ * @p_hot is the probability for a given write to be a hot page write.
+ * Note: within each area (Hot/Cold areas) the pages are picked uniformly. the hot pages are 0..U*Z*percentage/100
+ * and the cold pages are the rest.
+ */
+class HotColdSequenceSource : public SkewedSequenceSource {
+public:
+    HotColdSequenceSource(const SimConfig& config, RandomGenerator* rng, double hot_page_percentage, double p_hot) :
+            SkewedSequenceSource(rng) {
+        unsigned int logical_pages = config.logicalPages();
+        unsigned int hot_pages = (unsigned int)(logical_pages * (hot_page_percentage / 100)) + 1;
+        if (hot_pages >= logical_pages) {
+            addArea(0, logical_pages, 1);
+        }
+        else {
+            addArea(0, hot_pages, p_hot);
+            addArea(hot_pages, logical_pages - hot_pages, 1 - p_hot);
+        }
+        buildAreas();
+    }
+};
+
+/* tier i has the next tiers[i].page_percentage percent of the logical pages (rounded to whole pages), and is
+ * written with probability tiers[i].probability. the probabilities should sum up to 1.
+ */
+class TieredSequenceSource : public SkewedSequenceSource {
+public:
+    TieredSequenceSource(const SimConfig& config, RandomGenerator* rng, const vector<Tier>& tiers) :
+            SkewedSequenceSource(rng) {
+        unsigned int logical_pages = config.logicalPages();
+        unsigned int first_page = 0;
+        double percentage = 0;
+        for (unsigned int i = 0; i < tiers.size(); i++) {
+            percentage += tiers[i].page_percentage;
+            unsigned int end = logical_pages;
+            if (i + 1 < tiers.size()) {
+                end = std::min(logical_pages, (unsigned int)std::llround(logical_pages * (percentage / 100)));
+            }
+            if (end <= first_page) {
+                if (tiers[i].probability > 0) {
+                    cerr << "Error! tier " << i + 1 << " has no logical pages. Use --help for more information." << endl;
+                    exit(-1);
+                }
+                continue;
+            }
+            addArea(first_page, end - first_page, tiers[i].probability);
+            first_page = end;
+        }
+        buildAreas();
+    }
+};
+
+/* page r is written with probability proportional to 1/(r+1)^theta (theta >= 0, 0 is uniform). if scrambled,
+ * the weights are given to the pages in a random order, like the scrambled zipfian of YCSB.
+ */
+class ZipfSequenceSource : public SkewedSequenceSource {
+public:
+    ZipfSequenceSource(const SimConfig& config, RandomGenerator* rng, double theta, bool scrambled) :
+            SkewedSequenceSource(rng) {
+        unsigned int logical_pages = config.logicalPages();
+        vector<double> page_weights(logical_pages);
+        for (unsigned int r = 0; r < logical_pages; r++) {
+            page_weights[r] = std::pow(r + 1.0, -theta);
+        }
+        if (scrambled) {
+            /* Fisher-Yates shuffle, with a key of its own */
+            CounterRandom order(rng->streamKey(PAGE_ORDER_STREAM));
+            for (unsigned int i = logical_pages - 1; i > 0; i--) {
+                unsigned int range = i + 1;
+                std::swap(page_weights[i], page_weights[CounterRandom::uniform(order.at(i), range,
+                                                                               (0U - range) % range)]);
+            }
+        }
+        buildPages(page_weights);
+    }
+};
+
+/* TPC-C's NURand(A, 0, L-1) = ((random(0, A) | random(0, L-1)) + C) mod L, for the L = U*Z logical pages.
+ * A = 2^k - 1 is about L/16 (like TPC-C's A = 8191 for 100000 item ids), and C is a random constant in [0, A].
+ * the probability of every page is computed exactly, and the pages are picked from an alias table.
+ */
+class NURandSequenceSource : public SkewedSequenceSource {
+public:
+    NURandSequenceSource(const SimConfig& config, RandomGenerator* rng) : SkewedSequenceSource(rng) {
+        unsigned int logical_pages = config.logicalPages();
+        unsigned int bits = 0;
+        while (bits < 32 && ((logical_pages - 1ULL) >> bits) != 0) {
+            bits++;
+        }
+        unsigned int k = bits > 4 ? bits - 4 : 0;
+        unsigned int range = 1U << k;
+        unsigned long long constant = CounterRandom::uniform(rng->streamKey(NURAND_STREAM), range, (0U - range) % range);
+
+        /* random(0, A) has k random bits, so for r = random(0, L-1) the low k bits of r | random(0, A) are l with
+         * probability 2^(|b| - k) for every b = r's low k bits that is a subset of l (|b| is the number of bits of
+         * b). the high bits are the high bits of r. so if all of the 2^k b values are possible, the weight of l is
+         * the sum of 2^|b| over the subsets of l, which is 3^|l|. only the last block of 2^k values of r is partial.
+         */
+        vector<double> powers(k + 1, 1);
+        for (unsigned int i = 1; i <= k; i++) {
+            powers[i] = powers[i - 1] * 3;
+        }
+        unsigned long long last = logical_pages - 1ULL;
+        unsigned long long mask = (1ULL << k) - 1;
+        vector<double> page_weights(logical_pages, 0);
+        for (unsigned long long high = 0; high <= last >> k; high++) {
+            for (unsigned long long low = 0; low <= mask; low++) {
+                double weight = high < last >> k ? powers[std::bitset<64>(low).count()] :
+                                partialBlockWeight(low, last & mask, k, powers);
+                page_weights[((high << k | low) + constant) % logical_pages] += weight;
+            }
+        }
+        buildPages(page_weights);
+    }
+
+private:
+    /* the sum of 2^|b| over the subsets b of low that are at most last (the low bits of the last r). the bits are
+     * scanned from the top while b is equal to last: where last has a 1 bit, b can take a 0 (and then the lower
+     * bits of b are any subset of the lower bits of low), or a 1 if low has it.
+     */
+    static double partialBlockWeight(unsigned long long low, unsigned long long last, unsigned int k,
+                                     const vector<double>& powers) {
+        double weight = 0;
+        double equal = 1;
+        for (int bit = (int)k - 1; bit >= 0; bit--) {
+            unsigned long long mask = 1ULL << bit;
+            if (last & mask) {
+                weight += equal * powers[std::bitset<64>(low & (mask - 1)).count()];
+                if (!(low & mask)) {
+                    return weight;
+                }
+                equal *= 2;
+            }
+        }
+        return weight + equal;
+    }
+};
+
+/* generate a Hot & Cold pages writing sequence of length N */
+unsigned int* generateHotColdWriteSequence(const SimConfig& config, RandomGenerator* rng, double hot_page_percentage,
+                                           double p_hot, ThreadPool* pool = nullptr){
+    return generateWriteSequence(config, HotColdSequenceSource(config, rng, hot_page_percentage, p_hot), pool);
+}
+
+#endif //FLASHGC_SKEWEDSEQUENCESOURCE_H
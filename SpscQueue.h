@@ -0,0 +1,74 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	SpscQueue is a bounded lock-free queue for exactly one producer thread and one consumer thread. the producer
+ *	only writes tail and the consumer only writes head, so push and pop are a load and a store each, and an item
+ *	that was pushed (including the memory it points to) is visible to the consumer once it is popped.
+ */
+
+#ifndef FLASHGC_SPSCQUEUE_H
+#define FLASHGC_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+template <typename T>
+class SpscQueue {
+public:
+
+    /* @param capacity the maximal number of items in the queue, rounded up to a power of 2 */
+    explicit SpscQueue(size_t capacity) : head(0), tail(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /* producer only. returns false if the queue is full */
+    bool push(const T& item) {
+        size_t current_tail = tail.load(std::memory_order_relaxed);
+        if (current_tail - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[current_tail & mask] = item;
+        tail.store(current_tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* consumer only. returns false if the queue is empty */
+    bool pop(T* item) {
+        size_t current_head = head.load(std::memory_order_relaxed);
+        if (current_head == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        *item = slots[current_head & mask];
+        head.store(current_head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    vector<T> slots;
+    size_t mask;
+
+    /* head and tail are written by different threads, so keep them on different cache lines. the queue is
+     * allocated with new, which doesn't honor alignas before C++17, so pad instead of aligning
+     */
+    char head_padding[64];
+    std::atomic<size_t> head;
+    char tail_padding[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail;
+    char end_padding[64 - sizeof(std::atomic<size_t>)];
+};
+
+#endif //FLASHGC_SPSCQUEUE_H
@@ -0,0 +1,503 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	Sweep runs a grid of simulations in one process. the grid is read from a text file with one parameter per line:
+ *
+ *		# comment
+ *		T = 64, 128				(physical blocks)
+ *		U = 50					(logical blocks)
+ *		Z = 32					(pages per block)
+ *		N = 100000:500000:100000		(number of pages in the writing sequence)
+ *		page_size = 4096			(optional, default 4096)
+ *		algorithm = greedy, greedy_lookahead, generational
+ *		distribution = uniform, hot_cold	(optional, default uniform. the other distributions are not supported)
+ *		hot_percentage = 5, 10			(hot_cold only)
+ *		hot_probability = 0.9			(hot_cold only)
+ *		window = 0				(optional, look ahead window size. 0 (default) for no window)
+ *		generations = 0, 2			(optional, generational only. 0 (default) for the OF heuristic)
+ *		seed = 1:8				(optional. without it all runs use the default fixed seed)
+ *
+ *	integer values can be given as a list of values and ranges (from:to or from:to:step, inclusive). the runs are
+ *	all the combinations of the values, where parameters that don't affect a run (e.g. the number of generations of
+ *	a greedy run) are ignored, so every distinct run is simulated once.
+ *	runs with the same seed, distribution and sequence length (and the same number of logical pages) share one
+ *	read-only writing sequence. it is generated by the first run that needs it, and freed after the last one.
+ *	every run starts from the random state right after the sequence was generated, so a run gives the same result
+ *	as the equivalent single simulation.
+ *	the runs are scheduled on a work-stealing pool (the longest runs first), and one CSV result row is written per
+ *	run, in the grid order.
+ */
+
+#ifndef FLASHGC_SWEEP_H
+#define FLASHGC_SWEEP_H
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "AlgoRunner.h"
+#include "WorkStealingPool.h"
+
+using std::string;
+using std::vector;
+
+#define NOT_RELEVANT -1
+
+/* one simulation of the sweep */
+class SweepRun {
+public:
+    SimConfig config;
+    string algo_name;
+    Algorithm algo;
+    string dist_name;
+    PageDistribution page_dist;
+    int hot_percentage;
+    double hot_probability;
+    unsigned long long window_size;
+    int generations;
+    bool seeded;
+    unsigned long long seed;
+
+    /* index of the shared writing sequence of this run */
+    int sequence;
+
+    /* results */
+    unsigned long long warmup_writes;
+    long long erases;
+    double write_amplification;
+    double seconds;
+};
+
+/* a writing sequence shared between runs */
+class SharedSequence {
+public:
+    /* the parameters the sequence depends on */
+    SimConfig config;
+    PageDistribution page_dist;
+    int hot_percentage;
+    double hot_probability;
+    bool seeded;
+    unsigned long long seed;
+
+    std::once_flag generated;
+    unsigned int* writing_sequence;
+
+    /* the random state right after the sequence was generated */
+    RandomGenerator rng;
+
+    /* number of runs that did not finish using the sequence yet */
+    int remaining_runs;
+
+    SharedSequence() : page_dist(UNIFORM), hot_percentage(NOT_RELEVANT), hot_probability(NOT_RELEVANT), seeded(false),
+                       seed(0), writing_sequence(nullptr), remaining_runs(0) {}
+};
+
+class Sweep {
+public:
+
+    /* read the grid from file_name and expand it to runs. exits on an invalid grid */
+    explicit Sweep(const char* file_name) {
+        parseGrid(file_name);
+        expandGrid();
+    }
+
+    ~Sweep() {
+        for (SharedSequence* sequence : sequences) {
+            delete [] sequence->writing_sequence;
+            delete sequence;
+        }
+    }
+
+    unsigned int numberOfRuns() const {
+        return runs.size();
+    }
+
+    /* run all the simulations on number_of_threads threads and write the result rows to out */
+    void run(int number_of_threads, std::ostream& out) {
+        out << "run,T,U,Z,page_size,N,distribution,hot_percentage,hot_probability,algorithm,window,generations,seed,"
+               "warmup_writes,erases,write_amplification,seconds" << std::endl;
+
+        /* the longest runs first. stable, so the schedule only depends on the grid */
+        vector<int> order(runs.size());
+        for (unsigned int i = 0; i < runs.size(); i++) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [this] (int l_val, int r_val) {
+            return estimatedCost(runs[l_val]) > estimatedCost(runs[r_val]);
+        });
+
+        done.assign(runs.size(), false);
+        next_row = 0;
+        vector<std::function<void()>> tasks;
+        for (int i : order) {
+            tasks.emplace_back([this, i, &out] {
+                runSimulation(&runs[i]);
+                reportRun(i, out);
+            });
+        }
+        WorkStealingPool pool(number_of_threads);
+        pool.run(tasks);
+    }
+
+private:
+    vector<SweepRun> runs;
+    vector<SharedSequence*> sequences;
+
+    /* the grid: parameter name -> values */
+    vector<pair<string, vector<string>>> grid;
+
+    /* rows are written in run order. done[i] is set when run i finished */
+    std::mutex output_mutex;
+    vector<bool> done;
+    unsigned int next_row;
+
+    static void gridError(const string& message) {
+        cerr << "Error! Invalid sweep grid: " << message << endl;
+        exit(-1);
+    }
+
+    static string trim(const string& str) {
+        size_t begin = str.find_first_not_of(" \t\r");
+        if (begin == string::npos) {
+            return "";
+        }
+        size_t end = str.find_last_not_of(" \t\r");
+        return str.substr(begin, end - begin + 1);
+    }
+
+    static bool isIntegerParameter(const string& name) {
+        return name == "T" || name == "U" || name == "Z" || name == "N" || name == "page_size" || name == "window" ||
+               name == "generations" || name == "hot_percentage" || name == "seed";
+    }
+
+    static unsigned long long parseUnsigned(const string& name, const string& value) {
+        char* end;
+        unsigned long long parsed = strtoull(value.c_str(), &end, 10);
+        if (value.empty() || value[0] == '-' || *end != '\0') {
+            gridError("invalid value '" + value + "' for " + name);
+        }
+        return parsed;
+    }
+
+    /* expand a value of an integer parameter: a number, from:to or from:to:step */
+    static void expandRange(const string& name, const string& value, vector<string>* values) {
+        vector<string> parts;
+        std::stringstream stream(value);
+        string part;
+        while (std::getline(stream, part, ':')) {
+            parts.push_back(trim(part));
+        }
+        if (parts.empty() || parts.size() > 3) {
+            gridError("invalid range '" + value + "' for " + name);
+        }
+        unsigned long long from = parseUnsigned(name, parts[0]);
+        unsigned long long to = parts.size() > 1 ? parseUnsigned(name, parts[1]) : from;
+        unsigned long long step = parts.size() > 2 ? parseUnsigned(name, parts[2]) : 1;
+        if (step == 0 || to < from) {
+            gridError("invalid range '" + value + "' for " + name);
+        }
+        for (unsigned long long i = from; i <= to; i += step) {
+            values->push_back(std::to_string(i));
+            if (to - i < step) {
+                break;
+            }
+        }
+    }
+
+    void parseGrid(const char* file_name) {
+        std::ifstream file(file_name);
+        if (!file) {
+            cerr << "Error! Cannot open sweep grid file " << file_name << "." << endl;
+            exit(-1);
+        }
+        static const char* known[] = {"T", "U", "Z", "N", "page_size", "algorithm", "distribution", "hot_percentage",
+                                      "hot_probability", "window", "generations", "seed"};
+        string line;
+        while (std::getline(file, line)) {
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) {
+                continue;
+            }
+            size_t equals = line.find('=');
+            if (equals == string::npos) {
+                gridError("expected 'name = values' in line '" + line + "'");
+            }
+            string name = trim(line.substr(0, equals));
+            if (std::find(std::begin(known), std::end(known), name) == std::end(known)) {
+                gridError("unknown parameter " + name);
+            }
+            if (gridValues(name)) {
+                gridError("parameter " + name + " is given twice");
+            }
+            vector<string> values;
+            std::stringstream stream(line.substr(equals + 1));
+            string value;
+            while (std::getline(stream, value, ',')) {
+                value = trim(value);
+                if (isIntegerParameter(name)) {
+                    expandRange(name, value, &values);
+                }
+                else {
+                    values.push_back(value);
+                }
+            }
+            if (values.empty()) {
+                gridError("no values for " + name);
+            }
+            grid.emplace_back(name, values);
+        }
+
+        const char* required[] = {"T", "U", "Z", "N", "algorithm"};
+        for (const char* name : required) {
+            if (!gridValues(name)) {
+                gridError(string("missing parameter ") + name);
+            }
+        }
+        setDefault("page_size", "4096");
+        setDefault("distribution", "uniform");
+        setDefault("window", "0");
+        setDefault("generations", "0");
+        setDefault("hot_percentage", std::to_string(NOT_RELEVANT));
+        setDefault("hot_probability", std::to_string(NOT_RELEVANT));
+    }
+
+    const vector<string>* gridValues(const string& name) const {
+        for (const auto& parameter : grid) {
+            if (parameter.first == name) {
+                return &parameter.second;
+            }
+        }
+        return nullptr;
+    }
+
+    void setDefault(const string& name, const string& value) {
+        if (!gridValues(name)) {
+            grid.emplace_back(name, vector<string>({value}));
+        }
+    }
+
+    /* go over all the combinations of the grid values, and add every distinct run */
+    void expandGrid() {
+        std::set<string> seen;
+        vector<unsigned int> index(grid.size(), 0);
+        while (true) {
+            SweepRun run = makeRun(index);
+            string key = runKey(run);
+            if (seen.insert(key).second) {
+                validateRun(run);
+                run.sequence = findSequence(run);
+                sequences[run.sequence]->remaining_runs++;
+                runs.push_back(run);
+            }
+
+            /* next combination (the last parameter changes fastest) */
+            int i = grid.size() - 1;
+            while (i >= 0 && ++index[i] == grid[i].second.size()) {
+                index[i] = 0;
+                i--;
+            }
+            if (i < 0) {
+                break;
+            }
+        }
+    }
+
+    SweepRun makeRun(const vector<unsigned int>& index) const {
+        SweepRun run;
+        run.seeded = false;
+        run.seed = 0;
+        for (unsigned int i = 0; i < grid.size(); i++) {
+            const string& name = grid[i].first;
+            const string& value = grid[i].second[index[i]];
+            if (name == "T") run.config.physical_blocks = std::stoi(value);
+            else if (name == "U") run.config.logical_blocks = std::stoi(value);
+            else if (name == "Z") run.config.pages_per_block = std::stoi(value);
+            else if (name == "page_size") run.config.page_size = std::stoi(value);
+            else if (name == "N") run.config.number_of_pages = std::stoull(value);
+            else if (name == "window") run.window_size = std::stoull(value);
+            else if (name == "generations") run.generations = std::stoi(value);
+            else if (name == "hot_percentage") run.hot_percentage = std::stoi(value);
+            else if (name == "hot_probability") run.hot_probability = std::stod(value);
+            else if (name == "algorithm") run.algo_name = value;
+            else if (name == "distribution") run.dist_name = value;
+            else if (name == "seed") {
+                run.seeded = true;
+                run.seed = std::stoull(value);
+            }
+        }
+        run.algo = algoStringToEnum(run.algo_name.c_str());
+        run.page_dist = distributionStringToEnum(run.dist_name.c_str());
+        if (run.algo == INVALID_ALGO) {
+            gridError("invalid algorithm " + run.algo_name);
+        }
+        if (run.page_dist != UNIFORM && run.page_dist != HOT_COLD) {
+            gridError("invalid distribution " + run.dist_name);
+        }
+
+        /* ignore the parameters that don't affect this run */
+        if (run.page_dist != HOT_COLD) {
+            run.hot_percentage = NOT_RELEVANT;
+            run.hot_probability = NOT_RELEVANT;
+        }
+        if (run.algo != GENERATIONAL) {
+            run.generations = NOT_RELEVANT;
+        }
+        if (isOnlineAlgorithm(run.algo) || run.algo == WRITING_ASSIGNMENT || run.window_size == 0) {
+            run.window_size = run.config.number_of_pages;
+        }
+        run.warmup_writes = 0;
+        run.erases = 0;
+        run.write_amplification = 0;
+        run.seconds = 0;
+        return run;
+    }
+
+    static string runKey(const SweepRun& run) {
+        std::stringstream key;
+        key << run.config.physical_blocks << ',' << run.config.logical_blocks << ',' << run.config.pages_per_block
+            << ',' << run.config.page_size << ',' << run.config.number_of_pages << ',' << run.algo << ','
+            << run.page_dist << ',' << run.hot_percentage << ',' << run.hot_probability << ',' << run.window_size
+            << ',' << run.generations << ',' << run.seeded << ',' << run.seed;
+        return key.str();
+    }
+
+    static void validateRun(const SweepRun& run) {
+        const SimConfig& config = run.config;
+        if (config.logical_blocks <= 0 || config.physical_blocks <= config.logical_blocks) {
+            gridError("T must be larger than U, and U must be positive");
+        }
+        if (config.pages_per_block <= 0 || config.page_size <= 0 || config.number_of_pages == 0) {
+            gridError("Z, page_size and N must be positive");
+        }
+        if (run.window_size > config.number_of_pages) {
+            gridError("window size must be at most N");
+        }
+        if (run.algo == GENERATIONAL && run.generations > config.physical_blocks - config.logical_blocks) {
+            gridError("number of generations must be at most T-U");
+        }
+        if (run.page_dist == HOT_COLD && (run.hot_percentage < 0 || run.hot_percentage > 100 ||
+                                          run.hot_probability < 0 || run.hot_probability > 1)) {
+            gridError("hot_cold needs hot_percentage in 0-100 and hot_probability in 0-1");
+        }
+    }
+
+    /* find (or add) the shared sequence of the run */
+    int findSequence(const SweepRun& run) {
+        for (unsigned int i = 0; i < sequences.size(); i++) {
+            const SharedSequence& sequence = *sequences[i];
+            if (sequence.config.logicalPages() == run.config.logicalPages() &&
+                sequence.config.number_of_pages == run.config.number_of_pages && sequence.page_dist == run.page_dist &&
+                sequence.hot_percentage == run.hot_percentage && sequence.hot_probability == run.hot_probability &&
+                sequence.seeded == run.seeded && sequence.seed == run.seed) {
+                return i;
+            }
+        }
+        SharedSequence* sequence = new SharedSequence();
+        sequence->config = run.config;
+        sequence->page_dist = run.page_dist;
+        sequence->hot_percentage = run.hot_percentage;
+        sequence->hot_probability = run.hot_probability;
+        sequence->seeded = run.seeded;
+        sequence->seed = run.seed;
+        sequences.push_back(sequence);
+        return sequences.size() - 1;
+    }
+
+    static double estimatedCost(const SweepRun& run) {
+        /* the adaptive steady state warmup fills the logical pages, and then usually converges after a few windows
+         * of erases (with about Z/2 writes per erase). the look ahead algorithms cost more per write
+         */
+        double warmup = run.config.logicalPages() + (WARMUP_STABLE_WINDOWS + 1.0) *
+                        std::max(run.config.physical_blocks, WARMUP_MIN_WINDOW_ERASES) * run.config.pages_per_block / 2;
+        double writes = (double)run.config.number_of_pages + warmup;
+        return isOnlineAlgorithm(run.algo) ? writes : 2 * writes;
+    }
+
+    void runSimulation(SweepRun* run) {
+        auto start = std::chrono::steady_clock::now();
+        SharedSequence* sequence = sequences[run->sequence];
+        std::call_once(sequence->generated, [sequence] {
+            if (sequence->seeded) {
+                sequence->rng.seed(sequence->seed);
+            }
+            if (sequence->page_dist == UNIFORM) {
+                sequence->writing_sequence = generateUniformlyDistributedWriteSequence(sequence->config, &sequence->rng);
+            }
+            else {
+                sequence->writing_sequence = generateHotColdWriteSequence(sequence->config, &sequence->rng,
+                                                                          sequence->hot_percentage,
+                                                                          sequence->hot_probability);
+            }
+        });
+
+        UserParameters user_parameters;
+        user_parameters.window_size = run->window_size;
+        user_parameters.number_of_generations = run->generations == NOT_RELEVANT ? 0 : run->generations;
+        user_parameters.hot_pages_percentage = run->hot_percentage;
+        user_parameters.hot_pages_probability = run->hot_probability;
+        {
+            AlgoRunner runner(run->config, sequence->rng, sequence->writing_sequence, run->page_dist, run->algo,
+                              user_parameters);
+            runner.setVerbose(false);
+            runner.runSimulation(run->algo);
+            if (run->algo == GENERATIONAL) {
+                /* report the number of generations we actually used (in case of the OF heuristic) */
+                run->generations = runner.user_parameters.number_of_generations;
+            }
+            run->warmup_writes = runner.getWarmupWrites();
+            run->erases = runner.getErases();
+            run->write_amplification = runner.getWriteAmplification();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            if (--sequence->remaining_runs == 0) {
+                delete [] sequence->writing_sequence;
+                sequence->writing_sequence = nullptr;
+            }
+        }
+        run->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /* mark run i as done, and write all the rows that are ready (in run order) */
+    void reportRun(unsigned int i, std::ostream& out) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        done[i] = true;
+        for (; next_row < runs.size() && done[next_row]; next_row++) {
+            const SweepRun& run = runs[next_row];
+            out << next_row << ',' << run.config.physical_blocks << ',' << run.config.logical_blocks << ','
+                << run.config.pages_per_block << ',' << run.config.page_size << ',' << run.config.number_of_pages << ','
+                << run.dist_name << ',';
+            if (run.page_dist == HOT_COLD) {
+                out << run.hot_percentage << ',' << run.hot_probability << ',';
+            }
+            else {
+                out << "-,-,";
+            }
+            out << run.algo_name << ',' << run.window_size << ',';
+            if (run.algo == GENERATIONAL) {
+                out << run.generations << ',';
+            }
+            else {
+                out << "-,";
+            }
+            if (run.seeded) {
+                out << run.seed << ',';
+            }
+            else {
+                out << "default,";
+            }
+            out << run.warmup_writes << ',' << run.erases << ',' << run.write_amplification << ',' << run.seconds << std::endl;
+        }
+    }
+};
+
+#endif //FLASHGC_SWEEP_H
@@ -0,0 +1,252 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	Telemetry records a time series of the simulation: every K erases (or K host writes) it samples the cumulative
+ *	write amplification, Y, the length of the free list and the sizes of the V buckets. the samples are taken into
+ *	a preallocated ring of slots, and a writer thread formats them to a file in the background. the slots pass
+ *	between the threads through two SpscQueues (like the chunks of a pipelined SequenceStream), so a sample costs
+ *	Z+5 loads and a queue push, and the simulation only waits for the writer if it falls a whole ring behind.
+ *
+ *	CSV_TELEMETRY writes one line per sample:
+ *	host_writes,erases,write_amplification,Y,free_blocks,V0,...,VZ
+ *	BINARY_TELEMETRY writes a TelemetryFileHeader followed by fixed size records (in the byte order of the machine
+ *	that wrote the file): uint64 host_writes, uint64 erases, double write_amplification, int32 Y,
+ *	uint32 free_blocks and Z+1 uint32 bucket sizes.
+ *	host_writes and erases are counted from the steady state, like the results of the simulation.
+ */
+
+#ifndef FLASHGC_TELEMETRY_H
+#define FLASHGC_TELEMETRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "Auxilaries.h"
+#include "FTL.hpp"
+#include "SpscQueue.h"
+
+#define TELEMETRY_MAGIC "FGCTEL1"
+#define TELEMETRY_VERSION 1
+
+/* the number of sample slots, i.e. how far the simulation may run ahead of the writer thread */
+#define TELEMETRY_SLOTS 4096
+
+/* how long the writer thread sleeps when there are no samples to write */
+#define TELEMETRY_IDLE_MICROSECONDS 1000
+
+using std::vector;
+
+class TelemetryOptions {
+public:
+    /* the file to write the samples to, or nullptr for no telemetry */
+    const char* path;
+    /* sample every `every` erases or host writes (0 for every T erases, or every T*Z host writes) */
+    unsigned long long every;
+    TelemetryUnit unit;
+    TelemetryFormat format;
+
+    TelemetryOptions() : path(nullptr), every(0), unit(TELEMETRY_ERASES), format(CSV_TELEMETRY) {}
+};
+
+class TelemetryFileHeader {
+public:
+    char magic[8];
+    uint32_t version;
+    /* Z+1, the number of bucket sizes in every record */
+    uint32_t buckets;
+    uint32_t physical_blocks;
+    uint32_t logical_blocks;
+    /* TelemetryUnit, and the number of erases or host writes between two samples */
+    uint32_t unit;
+    uint32_t reserved;
+    uint64_t every;
+};
+
+static_assert(sizeof(TelemetryFileHeader) == 40, "TelemetryFileHeader must not have padding");
+
+class TelemetrySample {
+public:
+    uint64_t host_writes;
+    uint64_t erases;
+    double write_amplification;
+    int32_t Y;
+    uint32_t free_blocks;
+};
+
+static_assert(sizeof(TelemetrySample) == 32, "TelemetrySample must not have padding");
+
+class Telemetry {
+public:
+    /* create the file and start the writer thread */
+    Telemetry(const SimConfig& config, const TelemetryOptions& options) :
+            path(options.path), format(options.format), by_erases(options.unit == TELEMETRY_ERASES),
+            buckets(config.pages_per_block + 1), next_sample(0), last_sample(~0ULL), samples(TELEMETRY_SLOTS),
+            histograms((size_t)TELEMETRY_SLOTS * buckets), full_slots(TELEMETRY_SLOTS), free_slots(TELEMETRY_SLOTS),
+            stop_writer(false) {
+        every = options.every;
+        if (every == 0) {
+            every = by_erases ? config.physical_blocks : config.physicalPages();
+        }
+        file = fopen(path, format == BINARY_TELEMETRY ? "wb" : "w");
+        if (!file) {
+            std::cerr << "Error! Could not create telemetry file " << path << "." << std::endl;
+            exit(-1);
+        }
+        if (format == BINARY_TELEMETRY) {
+            TelemetryFileHeader header;
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, TELEMETRY_MAGIC, sizeof(header.magic));
+            header.version = TELEMETRY_VERSION;
+            header.buckets = buckets;
+            header.physical_blocks = config.physical_blocks;
+            header.logical_blocks = config.logical_blocks;
+            header.unit = options.unit;
+            header.every = every;
+            put(&header, sizeof(header));
+        }
+        else {
+            fprintf(file, "host_writes,erases,write_amplification,Y,free_blocks");
+            for (int i = 0; i < buckets; i++) {
+                fprintf(file, ",V%d", i);
+            }
+            fprintf(file, "\n");
+        }
+        for (uint32_t slot = 0; slot < TELEMETRY_SLOTS; slot++) {
+            free_slots.push(slot);
+        }
+        writer = std::thread(&Telemetry::writerLoop, this);
+    }
+
+    ~Telemetry() {
+        close();
+    }
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    /* whether a sample is due after host_writes writes of the simulation (see sample) */
+    bool due(unsigned long long host_writes, long long erases) const {
+        return (by_erases ? (unsigned long long)erases : host_writes) >= next_sample;
+    }
+
+    /* sample the FTL after host_writes writes of the simulation (counted from the steady state). the next sample is
+     * due `every` erases or host writes from now
+     */
+    void sample(FTL* ftl, unsigned long long host_writes) {
+        unsigned long long erases = ftl->erases - ftl->erases_steady;
+        if (host_writes == last_sample) {
+            return;
+        }
+        last_sample = host_writes;
+        next_sample = (by_erases ? ftl->erases : host_writes) + every;
+
+        uint32_t slot;
+        while (!free_slots.pop(&slot)) {
+            std::this_thread::yield();
+        }
+        TelemetrySample& sample = samples[slot];
+        long long logical_page_writes = ftl->logicalPageWrites - ftl->logicalPageWritesSteady;
+        sample.host_writes = host_writes;
+        sample.erases = erases;
+        sample.write_amplification = logical_page_writes > 0 ?
+                (double)(ftl->physicalPageWrites - ftl->physicalPageWritesSteady) / logical_page_writes : 0;
+        sample.Y = ftl->Y;
+        sample.free_blocks = ftl->freeList.size();
+        uint32_t* histogram = histograms.data() + (size_t)slot * buckets;
+        for (int i = 0; i < buckets; i++) {
+            histogram[i] = ftl->V[i].size();
+        }
+        /* the slots are in one of the queues, so there is always room */
+        full_slots.push(slot);
+    }
+
+    /* write the remaining samples, stop the writer thread and close the file */
+    void close() {
+        if (!writer.joinable()) {
+            return;
+        }
+        stop_writer.store(true, std::memory_order_release);
+        writer.join();
+        if (fclose(file) != 0) {
+            fail();
+        }
+    }
+
+private:
+    void writerLoop() {
+        vector<char> line;
+        while (true) {
+            /* read the flag before the queue, so no sample that was pushed before it was set is left behind */
+            bool stopping = stop_writer.load(std::memory_order_acquire);
+            uint32_t slot;
+            if (!full_slots.pop(&slot)) {
+                if (stopping) {
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(TELEMETRY_IDLE_MICROSECONDS));
+                continue;
+            }
+            const TelemetrySample& sample = samples[slot];
+            const uint32_t* histogram = histograms.data() + (size_t)slot * buckets;
+            if (format == BINARY_TELEMETRY) {
+                put(&sample, sizeof(sample));
+                put(histogram, sizeof(uint32_t) * buckets);
+            }
+            else {
+                fprintf(file, "%llu,%llu,%.6g,%d,%u", (unsigned long long)sample.host_writes,
+                        (unsigned long long)sample.erases, sample.write_amplification, sample.Y, sample.free_blocks);
+                for (int i = 0; i < buckets; i++) {
+                    fprintf(file, ",%u", histogram[i]);
+                }
+                fprintf(file, "\n");
+            }
+            free_slots.push(slot);
+        }
+    }
+
+    void put(const void* buffer, size_t size) {
+        if (fwrite(buffer, 1, size, file) != size) {
+            fail();
+        }
+    }
+
+    [[noreturn]] void fail() const {
+        std::cerr << "Error! Could not write telemetry file " << path << "." << std::endl;
+        exit(-1);
+    }
+
+    const char* path;
+    TelemetryFormat format;
+    bool by_erases;
+    int buckets;
+    unsigned long long every;
+
+    /* the erases (total, not since the steady state) or host writes of the next sample, and the host writes of
+     * the last one
+     */
+    unsigned long long next_sample;
+    unsigned long long last_sample;
+
+    /* the sample slots, and the bucket sizes of every slot */
+    vector<TelemetrySample> samples;
+    vector<uint32_t> histograms;
+
+    /* slots that were sampled and not written yet, and slots that are free to sample into */
+    SpscQueue<uint32_t> full_slots;
+    SpscQueue<uint32_t> free_slots;
+
+    FILE* file;
+    std::atomic<bool> stop_writer;
+    std::thread writer;
+};
+
+#endif //FLASHGC_TELEMETRY_H
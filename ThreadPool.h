@@ -0,0 +1,125 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	ThreadPool is a persistent pool of worker threads used to split loops over independent items (e.g. scoring
+ *	GC candidate blocks) between several cores. The workers are created once and sleep between jobs, so a job
+ *	only costs a wake up and not a thread creation.
+ *	A job [0,n) is split into contiguous chunks, one per thread, and the calling thread works on the first chunk.
+ *	The chunks only depend on n and the pool size, and each item is handled by exactly one thread, so as long as
+ *	the task writes every item to its own slot the result is the same as a sequential loop.
+ */
+
+#ifndef FLASHGC_THREADPOOL_H
+#define FLASHGC_THREADPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+class ThreadPool {
+public:
+
+    /* @param number_of_threads total number of threads working on a job, including the calling thread */
+    explicit ThreadPool(int number_of_threads) :
+            number_of_threads(number_of_threads < 1 ? 1 : number_of_threads), job_size(0), generation(0), pending(0),
+            stop(false) {
+        for (int i = 1; i < this->number_of_threads; i++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        job_ready.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const {
+        return number_of_threads;
+    }
+
+    /* call task(begin, end) on contiguous chunks that cover [0, n), and return once all chunks are done.
+     * must only be called from one thread at a time.
+     */
+    void parallelFor(size_t n, const std::function<void(size_t, size_t)>& task) {
+        if (number_of_threads == 1 || n < 2) {
+            task(0, n);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            job_size = n;
+            pending = number_of_threads - 1;
+            generation++;
+        }
+        job_ready.notify_all();
+
+        runChunk(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        job_done.wait(lock, [this] { return pending == 0; });
+        job = nullptr;
+    }
+
+private:
+    void runChunk(int thread_id) {
+        size_t begin = job_size * thread_id / number_of_threads;
+        size_t end = job_size * (thread_id + 1) / number_of_threads;
+        if (begin < end) {
+            (*job)(begin, end);
+        }
+    }
+
+    void workerLoop(int thread_id) {
+        unsigned long long seen_generation = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                job_ready.wait(lock, [this, seen_generation] { return stop || generation != seen_generation; });
+                if (stop) {
+                    return;
+                }
+                seen_generation = generation;
+            }
+
+            runChunk(thread_id);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                job_done.notify_one();
+            }
+        }
+    }
+
+    int number_of_threads;
+    vector<std::thread> workers;
+
+    /* the current job. guarded by mutex, and stays valid until all the workers are done with it */
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t job_size;
+    unsigned long long generation;
+    int pending;
+    bool stop;
+
+    std::mutex mutex;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+};
+
+#endif //FLASHGC_THREADPOOL_H
@@ -0,0 +1,355 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	TraceSequenceSource replays the writes of a block I/O trace as a writing sequence.
+ *	Supported formats:
+ *	msr - the MSR Cambridge / SNIA CSV format, one request per line:
+ *		Timestamp,Hostname,DiskNumber,Type,Offset,Size,ResponseTime
+ *		where Type is Read or Write, and Offset and Size are in bytes.
+ *	blkparse - the default text output of blkparse:
+ *		8,0    3        1     0.000000000   697  Q  WS 223490 + 8 [kjournald]
+ *		only queued (Q) requests whose RWBS field has a W (and no D, which is a discard) are replayed. the sector
+ *		and the number of sectors are in 512 byte units.
+ *	lines that don't match the format (headers, reads, blkparse summaries) are skipped.
+ *
+ *	A write of [offset, offset + size) writes every page it touches, in order. the page numbers are mapped to
+ *	logical pages either by folding them into the logical space (page mod U*Z), or by first numbering the distinct
+ *	pages densely in the order of their first write (and folding that number, if the trace has more than U*Z
+ *	distinct pages). if the sequence is longer than the trace, the trace is replayed again from the start.
+ *
+ *	The trace file is memory mapped and parsed in place, so there is no allocation per line (dense mapping only
+ *	allocates when a new page is seen). the line is found with memchr, and the fields and numbers within it are
+ *	scanned 8 bytes at a time, which takes the parser to about 1 GB/s on one core.
+ */
+
+#ifndef FLASHGC_TRACESOURCE_H
+#define FLASHGC_TRACESOURCE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include "SequenceSource.h"
+
+#define SECTOR_SIZE 512
+
+/* the byte b in all 8 bytes of a word, and the top bit of all 8 bytes */
+#define BYTES(b) (0x0101010101010101ULL * (unsigned char)(b))
+#define HIGH_BITS 0x8080808080808080ULL
+
+/* the word-at-a-time scanning assumes the first byte of a word is its least significant byte */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define TRACE_SCAN_WORDS 1
+#else
+#define TRACE_SCAN_WORDS 0
+#endif
+
+using std::cerr;
+using std::endl;
+
+/* the trace parameters of the simulation */
+class TraceOptions {
+public:
+    const char* path;
+    TraceFormat format;
+    LbaMapping lba_mapping;
+
+    TraceOptions() : path(nullptr), format(MSR_TRACE), lba_mapping(FOLD_LBA) {}
+};
+
+class TraceSequenceSource : public SequenceSource {
+public:
+    TraceSequenceSource(const SimConfig& config, const TraceOptions& options) :
+            format(options.format), lba_mapping(options.lba_mapping), logical_pages(config.logicalPages()),
+            page_size(config.page_size), page_shift(-1), next_page(0), end_page(0) {
+        /* a 64 bit division costs about as much as parsing the line, so use a shift when we can */
+        if ((page_size & (page_size - 1)) == 0) {
+            page_shift = 0;
+            while ((1ULL << page_shift) < page_size) {
+                page_shift++;
+            }
+        }
+
+        int fd = open(options.path, O_RDONLY);
+        if (fd < 0) {
+            cerr << "Error! Could not open trace file " << options.path << "." << endl;
+            exit(-1);
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+            cerr << "Error! Trace file " << options.path << " is empty." << endl;
+            exit(-1);
+        }
+        mapped_size = file_stat.st_size;
+        void* mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            cerr << "Error! Could not map trace file " << options.path << "." << endl;
+            exit(-1);
+        }
+        begin = (const char*)mapped;
+        end = begin + mapped_size;
+        cursor = begin;
+
+        if (!nextWrite()) {
+            cerr << "Error! Trace file " << options.path << " has no writes." << endl;
+            exit(-1);
+        }
+        rewind();
+    }
+
+    ~TraceSequenceSource() override {
+        munmap((void*)begin, mapped_size);
+    }
+
+    TraceSequenceSource(const TraceSequenceSource&) = delete;
+    TraceSequenceSource& operator=(const TraceSequenceSource&) = delete;
+
+    void fill(unsigned int* buffer, unsigned long long count) override {
+        for (unsigned long long i = 0; i < count; ++i) {
+            while (next_page == end_page) {
+                if (!nextWrite()) {
+                    /* replay the trace from the start */
+                    cursor = begin;
+                }
+            }
+            buffer[i] = mapPage(next_page++);
+        }
+    }
+
+    /* the number of page writes in one pass over the trace. the source starts over from the start of the trace */
+    unsigned long long countPageWrites() {
+        unsigned long long page_writes = 0;
+        rewind();
+        while (nextWrite()) {
+            page_writes += end_page - next_page;
+        }
+        rewind();
+        return page_writes;
+    }
+
+private:
+    void rewind() {
+        cursor = begin;
+        next_page = end_page = 0;
+    }
+
+    unsigned int mapPage(unsigned long long page) {
+        if (lba_mapping == FOLD_LBA) {
+            return page % logical_pages;
+        }
+        auto iterator = dense_pages.find(page);
+        if (iterator != dense_pages.end()) {
+            return iterator->second;
+        }
+        unsigned int lpn = dense_pages.size() % logical_pages;
+        dense_pages.emplace(page, lpn);
+        return lpn;
+    }
+
+    /* parse the next write request of the trace into [next_page, end_page). returns false at the end of the trace */
+    bool nextWrite() {
+        unsigned long long offset, size;
+        while (cursor < end) {
+            const char* line = cursor;
+            const char* line_end = (const char*)memchr(cursor, '\n', end - cursor);
+            if (!line_end) {
+                line_end = end;
+                cursor = end;
+            }
+            else {
+                cursor = line_end + 1;
+            }
+            bool parsed = format == MSR_TRACE ? parseMsrLine(line, line_end, &offset, &size)
+                                              : parseBlkparseLine(line, line_end, &offset, &size);
+            if (parsed && size > 0) {
+                if (page_shift >= 0) {
+                    next_page = offset >> page_shift;
+                    end_page = ((offset + size - 1) >> page_shift) + 1;
+                }
+                else {
+                    next_page = offset / page_size;
+                    end_page = (offset + size - 1) / page_size + 1;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* Timestamp,Hostname,DiskNumber,Type,Offset,Size,ResponseTime */
+    static bool parseMsrLine(const char* p, const char* line_end, unsigned long long* offset,
+                             unsigned long long* size) {
+        for (int field = 0; field < 3; field++) {
+            p = findByte(p, line_end, ',');
+            if (p == line_end) {
+                return false;
+            }
+            p++;
+        }
+        if (p == line_end || (*p != 'W' && *p != 'w')) {
+            return false;
+        }
+        p = findByte(p, line_end, ',');
+        if (p == line_end) {
+            return false;
+        }
+        p++;
+        if (!parseNumber(&p, line_end, offset) || p == line_end || *p != ',') {
+            return false;
+        }
+        p++;
+        return parseNumber(&p, line_end, size);
+    }
+
+    /* dev cpu sequence time pid action RWBS sector + sectors [process] */
+    static bool parseBlkparseLine(const char* p, const char* line_end, unsigned long long* offset,
+                                  unsigned long long* size) {
+        const char* token;
+        size_t length;
+        for (int field = 0; field < 5; field++) {
+            if (!nextToken(&p, line_end, &token, &length)) {
+                return false;
+            }
+        }
+        if (!nextToken(&p, line_end, &token, &length) || length != 1 || *token != 'Q') {
+            return false;
+        }
+        if (!nextToken(&p, line_end, &token, &length) || !memchr(token, 'W', length) || memchr(token, 'D', length)) {
+            return false;
+        }
+        unsigned long long sector, sectors;
+        if (!nextToken(&p, line_end, &token, &length) || !parseNumber(&token, token + length, &sector)) {
+            return false;
+        }
+        if (!nextToken(&p, line_end, &token, &length) || length != 1 || *token != '+') {
+            return false;
+        }
+        if (!nextToken(&p, line_end, &token, &length) || !parseNumber(&token, token + length, &sectors)) {
+            return false;
+        }
+        *offset = sector * SECTOR_SIZE;
+        *size = sectors * SECTOR_SIZE;
+        return true;
+    }
+
+    /* find the next whitespace separated token in [*p, line_end) and move *p past it */
+    static bool nextToken(const char** p, const char* line_end, const char** token, size_t* length) {
+        const char* q = *p;
+        while (q < line_end && (*q == ' ' || *q == '\t')) {
+            q++;
+        }
+        const char* token_end = q;
+        while (token_end < line_end && *token_end != ' ' && *token_end != '\t' && *token_end != '\r') {
+            token_end++;
+        }
+        if (token_end == q) {
+            return false;
+        }
+        *token = q;
+        *length = token_end - q;
+        *p = token_end;
+        return true;
+    }
+
+    static unsigned long long loadWord(const char* p) {
+        unsigned long long word;
+        memcpy(&word, p, sizeof(word));
+        return word;
+    }
+
+    /* the first c in [p, line_end), or line_end */
+    static const char* findByte(const char* p, const char* line_end, char c) {
+#if TRACE_SCAN_WORDS
+        while (line_end - p >= 8) {
+            /* the top bit of the first zero byte of word is set in zeros (the later bytes may be wrong) */
+            unsigned long long word = loadWord(p) ^ BYTES(c);
+            unsigned long long zeros = (word - BYTES(1)) & ~word & HIGH_BITS;
+            if (zeros) {
+                return p + (__builtin_ctzll(zeros) >> 3);
+            }
+            p += 8;
+        }
+#endif
+        while (p < line_end && *p != c) {
+            p++;
+        }
+        return p;
+    }
+
+    /* parse a decimal number at *p and move *p past it. returns false if there are no digits */
+    static bool parseNumber(const char** p, const char* line_end, unsigned long long* value) {
+        const char* q = *p;
+        unsigned long long result = 0;
+#if TRACE_SCAN_WORDS
+        static const unsigned long long powers_of_10[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+                                                           100000000};
+        while (line_end - q >= 8) {
+            /* digits become 0..9, and the top bit of the first byte that is not a digit is set in non_digits
+             * (bytes below '0' wrap around to 0x80 and above, and bytes above '9' reach 0x80 when adding 0x76)
+             */
+            unsigned long long digits = loadWord(q) - BYTES('0');
+            unsigned long long non_digits = (digits | (digits + BYTES(0x76))) & HIGH_BITS;
+            int length = non_digits ? __builtin_ctzll(non_digits) >> 3 : 8;
+            if (length == 0) {
+                break;
+            }
+            /* move the digits to the top bytes (the first digit is the most significant one), then combine pairs
+             * of digits, pairs of 2 digit numbers and pairs of 4 digit numbers
+             */
+            if (length < 8) {
+                digits <<= 8 * (8 - length);
+            }
+            digits = ((digits & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+            digits = ((digits & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+            digits = ((digits & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+            result = result * powers_of_10[length] + digits;
+            q += length;
+            if (length < 8) {
+                *value = result;
+                *p = q;
+                return true;
+            }
+        }
+#endif
+        while (q < line_end && *q >= '0' && *q <= '9') {
+            result = result * 10 + (*q - '0');
+            q++;
+        }
+        if (q == *p) {
+            return false;
+        }
+        *value = result;
+        *p = q;
+        return true;
+    }
+
+    TraceFormat format;
+    LbaMapping lba_mapping;
+    unsigned int logical_pages;
+    unsigned long long page_size;
+
+    /* log2(page_size), or -1 if page_size is not a power of 2 */
+    int page_shift;
+
+    /* the mapped trace file, and the start of the next line to parse */
+    const char* begin;
+    const char* end;
+    const char* cursor;
+    size_t mapped_size;
+
+    /* the pages of the current write that were not given yet */
+    unsigned long long next_page;
+    unsigned long long end_page;
+
+    /* DENSE_LBA only: the logical page of every page seen so far */
+    std::unordered_map<unsigned long long, unsigned int> dense_pages;
+};
+
+#endif //FLASHGC_TRACESOURCE_H
@@ -0,0 +1,98 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+
+/*
+ *	WorkStealingPool runs a batch of independent tasks (e.g. whole simulations of a parameter sweep) on several
+ *	threads. the tasks are dealt round robin to per-thread deques, in the given order. every thread works on its own
+ *	deque in that order, and when it runs out of work it steals from the far end of another deque (the last tasks
+ *	that were dealt to it). so if the tasks are given from the longest to the shortest, every thread starts with
+ *	the longest tasks, and the short tasks at the end of the batch are used to balance the load.
+ */
+
+#ifndef FLASHGC_WORKSTEALINGPOOL_H
+#define FLASHGC_WORKSTEALINGPOOL_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+class WorkStealingPool {
+public:
+
+    explicit WorkStealingPool(int number_of_threads) :
+            number_of_threads(number_of_threads < 1 ? 1 : number_of_threads) {}
+
+    int size() const {
+        return number_of_threads;
+    }
+
+    /* run all the tasks and return once they are all done. tasks must not add tasks to the pool */
+    void run(vector<std::function<void()>>& tasks) {
+        queues.clear();
+        for (int i = 0; i < number_of_threads; i++) {
+            queues.emplace_back(new Queue());
+        }
+        for (unsigned int i = 0; i < tasks.size(); i++) {
+            queues[i % number_of_threads]->tasks.push_back(&tasks[i]);
+        }
+
+        vector<std::thread> workers;
+        for (int i = 1; i < number_of_threads; i++) {
+            workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+        workerLoop(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+private:
+    class Queue {
+    public:
+        std::mutex mutex;
+        std::deque<std::function<void()>*> tasks;
+    };
+
+    /* take the next task from the front of our own queue, or steal one from the back of another queue.
+     * returns nullptr when all the queues are empty.
+     */
+    std::function<void()>* nextTask(int thread_id) {
+        {
+            Queue& own = *queues[thread_id];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                std::function<void()>* task = own.tasks.front();
+                own.tasks.pop_front();
+                return task;
+            }
+        }
+        for (int i = 1; i < number_of_threads; i++) {
+            Queue& victim = *queues[(thread_id + i) % number_of_threads];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                std::function<void()>* task = victim.tasks.back();
+                victim.tasks.pop_back();
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    void workerLoop(int thread_id) {
+        while (std::function<void()>* task = nextTask(thread_id)) {
+            (*task)();
+        }
+    }
+
+    int number_of_threads;
+    vector<std::unique_ptr<Queue>> queues;
+};
+
+#endif //FLASHGC_WORKSTEALINGPOOL_H
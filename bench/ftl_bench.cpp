@@ -0,0 +1,411 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+/*
+ *	Microbenchmarks for the hot paths of the simulator. Every benchmark runs on a small, a medium and a large
+ *	memory layout from a fixed seed, so two builds of the simulator do exactly the same work, and a performance
+ *	change can be measured by running the benchmarks before and after it. The FTL benchmarks start from a steady
+ *	state of random greedy writes (twice the logical pages), and the writing sequence is BENCH_WRITES writes.
+ *	For every benchmark and layout we report the number of operations timed, the average time of an operation
+ *	and the pages processed per second, where an operation and its pages are:
+ *
+ *	uniform_sequence        generating one write of a uniform writing sequence (1 page)
+ *	hot_cold_sequence       generating one write of a hot/cold writing sequence, 20% hot pages written with
+ *	                        probability 0.8 (1 page)
+ *	greedy_write            FTL::write of one page with greedy GC, including the GCs it triggers (1 page)
+ *	gc                      FTL::GC, taken whenever the free list runs out (the valid pages it relocates)
+ *	cost_benefit_gc         the same with the cost-benefit victim selection
+ *	cat_gc                  the same with the cost-age-times victim selection
+ *	block_score             FTL::getBlockScore of one full block, on every block before a look ahead GC (the
+ *	                        valid pages of the block)
+ *	best_block_to_evict     FTL::getBestBlockToEvict before a look ahead GC (the valid pages of the candidates)
+ *	locations_map           AlgoRunner::createLocationsMap of one writing assignment window (the writes in it)
+ *	writing_assignment      AlgoRunner::getWritingAssignment of one window, during a writing assignment run (the
+ *	                        writes in it)
+ *
+ *	usage: ./ftl_bench [benchmark ...] [small|medium|large ...] [--csv]
+ *	(all the benchmarks on all the layouts by default)
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include "../AlgoRunner.h"
+
+#define BENCH_SEED 1
+
+/* the length of the writing sequence (N) on every layout */
+#define BENCH_WRITES (1ULL << 22)
+
+/* the look ahead GCs timed by block_score and best_block_to_evict */
+#define BLOCK_SCORE_GCS 256
+#define BEST_BLOCK_GCS 4096
+
+/* the windows timed by locations_map and writing_assignment */
+#define LOCATIONS_MAP_WINDOWS 64
+#define WRITING_ASSIGNMENT_WINDOWS 32
+
+using namespace std;
+
+void printHelp() {}
+
+typedef chrono::steady_clock Clock;
+
+class Geometry {
+public:
+    const char* name;
+    int physical_blocks;
+    int logical_blocks;
+    int pages_per_block;
+};
+
+static const Geometry geometries[] = {
+        {"small", 128, 112, 32},
+        {"medium", 1024, 896, 64},
+        {"large", 4096, 3584, 128},
+};
+
+/* the operations a benchmark timed, their total time and the pages they processed */
+class BenchResult {
+public:
+    unsigned long long ops;
+    unsigned long long pages;
+    double ns;
+
+    BenchResult() : ops(0), pages(0), ns(0) {}
+};
+
+/* the scores the benchmarks compute are summed here, so the compiler can't drop them */
+static volatile double score_sink;
+
+static double elapsedNs(Clock::time_point start) {
+    return chrono::duration<double, nano>(Clock::now() - start).count();
+}
+
+static SimConfig makeConfig(const Geometry& geometry) {
+    return SimConfig(geometry.physical_blocks, geometry.logical_blocks, geometry.pages_per_block, 4096, BENCH_WRITES);
+}
+
+/* bring the FTL to a steady state with random greedy writes */
+static void warmUp(FTL* ftl, RandomGenerator* rng) {
+    char data[1] = {0};
+    for (unsigned long long i = 0; i < 2ULL * ftl->config.logicalPages(); i++) {
+        ftl->write(data, rng->uniform(ftl->config.logicalPages()), GREEDY);
+    }
+}
+
+static BenchResult benchUniformSequence(const SimConfig& config) {
+    BenchResult result;
+    RandomGenerator rng;
+    rng.seed(BENCH_SEED);
+    Clock::time_point start = Clock::now();
+    unsigned int* writing_sequence = generateUniformlyDistributedWriteSequence(config, &rng);
+    result.ns = elapsedNs(start);
+    result.ops = result.pages = config.number_of_pages;
+    delete [] writing_sequence;
+    return result;
+}
+
+static BenchResult benchHotColdSequence(const SimConfig& config) {
+    BenchResult result;
+    RandomGenerator rng;
+    rng.seed(BENCH_SEED);
+    Clock::time_point start = Clock::now();
+    unsigned int* writing_sequence = generateHotColdWriteSequence(config, &rng, 20, 0.8);
+    result.ns = elapsedNs(start);
+    result.ops = result.pages = config.number_of_pages;
+    delete [] writing_sequence;
+    return result;
+}
+
+static BenchResult benchGreedyWrite(const SimConfig& config) {
+    BenchResult result;
+    RandomGenerator rng;
+    rng.seed(BENCH_SEED);
+    unsigned int* writing_sequence = generateUniformlyDistributedWriteSequence(config, &rng);
+    FTL ftl(config);
+    warmUp(&ftl, &rng);
+    char data[1] = {0};
+    Clock::time_point start = Clock::now();
+    for (unsigned long long i = 0; i < config.number_of_pages; i++) {
+        ftl.write(data, writing_sequence[i], GREEDY);
+    }
+    result.ns = elapsedNs(start);
+    result.ops = result.pages = config.number_of_pages;
+    delete [] writing_sequence;
+    return result;
+}
+
+static BenchResult benchGC(const SimConfig& config, Algorithm algorithm) {
+    BenchResult result;
+    RandomGenerator rng;
+    rng.seed(BENCH_SEED);
+    unsigned int* writing_sequence = generateUniformlyDistributedWriteSequence(config, &rng);
+    FTL ftl(config);
+    warmUp(&ftl, &rng);
+    char data[1] = {0};
+    for (unsigned long long i = 0; i < config.number_of_pages; i++) {
+        if (ftl.freeList.empty()) {
+            long long relocated = ftl.physicalPageWrites;
+            Clock::time_point start = Clock::now();
+            ftl.GC(algorithm);
+            result.ns += elapsedNs(start);
+            result.pages += ftl.physicalPageWrites - relocated;
+            result.ops++;
+        }
+        ftl.write(data, writing_sequence[i], algorithm);
+    }
+    delete [] writing_sequence;
+    return result;
+}
+
+static BenchResult benchGreedyGC(const SimConfig& config) {
+    return benchGC(config, GREEDY);
+}
+
+static BenchResult benchCostBenefitGC(const SimConfig& config) {
+    return benchGC(config, COST_BENEFIT);
+}
+
+static BenchResult benchCostAgeTimesGC(const SimConfig& config) {
+    return benchGC(config, COST_AGE_TIMES);
+}
+
+/* an FTL at a steady state with the closed form look ahead scorer of a uniform writing sequence */
+class LookaheadFixture {
+public:
+    explicit LookaheadFixture(const SimConfig& config) : ftl(config) {
+        rng.seed(BENCH_SEED);
+        writing_sequence = generateUniformlyDistributedWriteSequence(config, &rng);
+        scorer = new LookaheadScorer(writing_sequence, config.number_of_pages, config.logicalPages(),
+                                     config.physicalPages(), ftl.optimized_params.first);
+        ftl.scorer = scorer;
+        warmUp(&ftl, &rng);
+    }
+
+    ~LookaheadFixture() {
+        delete scorer;
+        delete [] writing_sequence;
+    }
+
+    LookaheadFixture(const LookaheadFixture&) = delete;
+    LookaheadFixture& operator=(const LookaheadFixture&) = delete;
+
+    void write(unsigned long long i) {
+        char data[1] = {0};
+        ftl.write(data, writing_sequence[i], GREEDY_LOOKAHEAD, writing_sequence, i);
+    }
+
+    RandomGenerator rng;
+    unsigned int* writing_sequence;
+    FTL ftl;
+    LookaheadScorer* scorer;
+};
+
+static BenchResult benchBlockScore(const SimConfig& config) {
+    BenchResult result;
+    LookaheadFixture fixture(config);
+    FTL& ftl = fixture.ftl;
+    int gcs = 0;
+    for (unsigned long long i = 0; i < config.number_of_pages && gcs < BLOCK_SCORE_GCS; i++) {
+        if (ftl.freeList.empty()) {
+            ftl.updateMinValid();
+            vector<int> blocks_to_score;
+            ftl.getCandidateBlocks(&blocks_to_score, config.pages_per_block, NO_CANDIDATE_BUDGET);
+            double scores = 0;
+            Clock::time_point start = Clock::now();
+            for (int block_num : blocks_to_score) {
+                scores += ftl.getBlockScore(block_num, i, fixture.writing_sequence);
+            }
+            result.ns += elapsedNs(start);
+            score_sink = score_sink + scores;
+            for (int block_num : blocks_to_score) {
+                result.pages += ftl.blocks[block_num].valid;
+            }
+            result.ops += blocks_to_score.size();
+            gcs++;
+        }
+        fixture.write(i);
+    }
+    return result;
+}
+
+static BenchResult benchBestBlockToEvict(const SimConfig& config) {
+    BenchResult result;
+    LookaheadFixture fixture(config);
+    FTL& ftl = fixture.ftl;
+    int gcs = 0;
+    for (unsigned long long i = 0; i < config.number_of_pages && gcs < BEST_BLOCK_GCS; i++) {
+        /* with empty blocks (Y = 0) the GC doesn't look for the best block */
+        if (ftl.freeList.empty() && ftl.updateMinValid() > 0) {
+            Clock::time_point start = Clock::now();
+            Block* block = ftl.getBestBlockToEvict(fixture.writing_sequence, i);
+            result.ns += elapsedNs(start);
+            score_sink = score_sink + block->valid;
+            result.pages += (unsigned long long)ftl.V[ftl.Y].size() * ftl.Y;
+            result.ops++;
+            gcs++;
+        }
+        fixture.write(i);
+    }
+    return result;
+}
+
+/* a writing assignment simulation of a uniform writing sequence at a steady state */
+class WritingAssignmentFixture {
+public:
+    explicit WritingAssignmentFixture(const SimConfig& config) : writing_sequence(nullptr), runner(nullptr) {
+        RandomGenerator rng;
+        rng.seed(BENCH_SEED);
+        writing_sequence = generateUniformlyDistributedWriteSequence(config, &rng);
+        UserParameters user_parameters = UserParameters();
+        user_parameters.window_size = config.number_of_pages;
+        runner = new AlgoRunner(config, rng, writing_sequence, UNIFORM, WRITING_ASSIGNMENT, user_parameters);
+        runner->setVerbose(false);
+        WarmupOptions warmup;
+        warmup.writes = 2ULL * config.logicalPages();
+        runner->setWarmup(warmup);
+        runner->reachSteadyState();
+    }
+
+    ~WritingAssignmentFixture() {
+        delete runner;
+        delete [] writing_sequence;
+    }
+
+    WritingAssignmentFixture(const WritingAssignmentFixture&) = delete;
+    WritingAssignmentFixture& operator=(const WritingAssignmentFixture&) = delete;
+
+    unsigned int* writing_sequence;
+    AlgoRunner* runner;
+};
+
+static BenchResult benchLocationsMap(const SimConfig& config) {
+    BenchResult result;
+    WritingAssignmentFixture fixture(config);
+    /* the locations map only reads the writing sequence, so we take the windows one after the other */
+    unsigned int window_size = fixture.runner->getWindowSize();
+    for (unsigned long long base_index = 0; base_index < config.number_of_pages && result.ops < LOCATIONS_MAP_WINDOWS;
+         base_index += window_size) {
+        Clock::time_point start = Clock::now();
+        map<unsigned int,ListItem>* locations_list = fixture.runner->createLocationsMap(base_index, window_size);
+        result.ns += elapsedNs(start);
+        delete [] locations_list;
+        result.pages += std::min<unsigned long long>(window_size, config.number_of_pages - base_index);
+        result.ops++;
+    }
+    return result;
+}
+
+static BenchResult benchWritingAssignment(const SimConfig& config) {
+    BenchResult result;
+    WritingAssignmentFixture fixture(config);
+    AlgoRunner* runner = fixture.runner;
+    unsigned long long base_index = 0;
+    while (base_index < config.number_of_pages && result.ops < WRITING_ASSIGNMENT_WINDOWS) {
+        unsigned int window_size = runner->getWindowSize();
+        Clock::time_point start = Clock::now();
+        vector<pair<unsigned int,int>> writing_assignment = runner->getWritingAssignment(base_index, window_size);
+        result.ns += elapsedNs(start);
+        for (unsigned long long i = 0; i < writing_assignment.size() && base_index + i < config.number_of_pages; i++) {
+            runner->ftl->writeToBlock(runner->pageData(writing_assignment[i].first), writing_assignment[i].first,
+                                      writing_assignment[i].second, fixture.writing_sequence, base_index + i);
+            result.pages++;
+        }
+        result.ops++;
+        base_index += window_size;
+    }
+    return result;
+}
+
+class Benchmark {
+public:
+    const char* name;
+    BenchResult (*run)(const SimConfig& config);
+};
+
+static const Benchmark benchmarks[] = {
+        {"uniform_sequence", benchUniformSequence},
+        {"hot_cold_sequence", benchHotColdSequence},
+        {"greedy_write", benchGreedyWrite},
+        {"gc", benchGreedyGC},
+        {"cost_benefit_gc", benchCostBenefitGC},
+        {"cat_gc", benchCostAgeTimesGC},
+        {"block_score", benchBlockScore},
+        {"best_block_to_evict", benchBestBlockToEvict},
+        {"locations_map", benchLocationsMap},
+        {"writing_assignment", benchWritingAssignment},
+};
+
+static void printUsage() {
+    cerr << "usage: ./ftl_bench [benchmark ...] [small|medium|large ...] [--csv]" << endl << "benchmarks:";
+    for (const Benchmark& benchmark : benchmarks) {
+        cerr << " " << benchmark.name;
+    }
+    cerr << endl;
+}
+
+int main(int argc, char** argv) {
+    const int number_of_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+    const int number_of_geometries = sizeof(geometries) / sizeof(geometries[0]);
+    vector<bool> run_benchmark(number_of_benchmarks, false), run_geometry(number_of_geometries, false);
+    bool any_benchmark = false, any_geometry = false, csv = false;
+    for (int i = 1; i < argc; i++) {
+        bool known = false;
+        if (strcmp(argv[i], "--csv") == 0) {
+            csv = known = true;
+        }
+        for (int b = 0; b < number_of_benchmarks; b++) {
+            if (strcmp(argv[i], benchmarks[b].name) == 0) {
+                run_benchmark[b] = any_benchmark = known = true;
+            }
+        }
+        for (int g = 0; g < number_of_geometries; g++) {
+            if (strcmp(argv[i], geometries[g].name) == 0) {
+                run_geometry[g] = any_geometry = known = true;
+            }
+        }
+        if (!known) {
+            cerr << "Error! Unknown benchmark or memory layout " << argv[i] << "." << endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (csv) {
+        cout << "benchmark,layout,T,U,Z,ops,ns_per_op,pages_per_second" << endl;
+    }
+    else {
+        cout << left << setw(22) << "benchmark" << setw(24) << "layout" << right << setw(12) << "ops"
+             << setw(14) << "ns/op" << setw(16) << "pages/sec" << endl;
+    }
+    for (int b = 0; b < number_of_benchmarks; b++) {
+        if (any_benchmark && !run_benchmark[b]) {
+            continue;
+        }
+        for (int g = 0; g < number_of_geometries; g++) {
+            if (any_geometry && !run_geometry[g]) {
+                continue;
+            }
+            const Geometry& geometry = geometries[g];
+            BenchResult result = benchmarks[b].run(makeConfig(geometry));
+            double ns_per_op = result.ops ? result.ns / result.ops : 0;
+            double pages_per_second = result.ns > 0 ? result.pages / (result.ns / 1e9) : 0;
+            if (csv) {
+                cout << benchmarks[b].name << "," << geometry.name << "," << geometry.physical_blocks << ","
+                     << geometry.logical_blocks << "," << geometry.pages_per_block << "," << result.ops << ","
+                     << fixed << setprecision(1) << ns_per_op << "," << setprecision(0) << pages_per_second << endl;
+            }
+            else {
+                string layout = string(geometry.name) + " (" + to_string(geometry.physical_blocks) + "/" +
+                                to_string(geometry.logical_blocks) + "/" + to_string(geometry.pages_per_block) + ")";
+                cout << left << setw(22) << benchmarks[b].name << setw(24) << layout << right << setw(12) << result.ops
+                     << fixed << setprecision(1) << setw(14) << ns_per_op << setprecision(0) << setw(16)
+                     << pages_per_second << endl;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+/*
+ *	Benchmark for the victim selection cost of Greedy LookAhead GC.
+ *	We bring a large memory layout to steady state, and then on every GC of a greedy_lookahead run
+ *	we score all the candidate blocks twice: once with the FTL block score function (the closed form of
+ *	LookaheadScorer) and once with a reference implementation of the original function, which scans the
+ *	writing sequence and finds the logical page number of each page with a linear scan over the mapping
+ *	table. Both must give the same scores, and we report the average cost of scoring the candidates of
+ *	one GC for each of them. The closed form replaces both the sequence scan and the linear lookup, so the
+ *	speedup is that of the two changes together, not of the O(1) logical page number lookup alone.
+ *
+ *	usage: ./lookahead_gc_bench [T U Z number_of_gcs]
+ */
+
+#include <iostream>
+#include <chrono>
+#include "../AlgoRunner.h"
+
+using namespace std;
+
+void printHelp() {}
+
+/* the logical page number lookup as it was before it became O(1): scan the whole
+ * mapping table for the logical page that is mapped to the physical page.
+ */
+static int linearScanLogicalPageNumber(const FTL& ftl, unsigned int ppn) {
+    for (unsigned int lpn = 0 ; lpn < ftl.config.logicalPages(); ++lpn) {
+        if (ftl.mappingTable[lpn] == ppn){
+            return lpn;
+        }
+    }
+    return -1;
+}
+
+/* FTL::getBlockScore with the linear scan lookup */
+static double linearScanBlockScore(const FTL& ftl, int block_num, unsigned long long base_index, const unsigned int* writing_sequence) {
+    const Block* curr_block = &ftl.blocks[block_num];
+    set<int> pages_in_block;
+    for (int i = 0; i < ftl.config.pages_per_block; ++i) {
+        if (curr_block->pageStatus(i) == VALID){
+            pages_in_block.insert(linearScanLogicalPageNumber(ftl, curr_block->physicalPageNumber(i)));
+        }
+    }
+    double block_score = 0;
+    for (unsigned long long i = base_index ; i < base_index + ftl.config.physicalPages() && i < ftl.config.number_of_pages ; i++){
+        if (pages_in_block.find(writing_sequence[i]) != pages_in_block.end()){
+            pages_in_block.erase(writing_sequence[i]);
+            if (pages_in_block.empty()){
+                return block_score;
+            }
+        }
+        long long div_value = i - base_index;
+        block_score += div_value > 0 ? (pages_in_block.size()/(double)pow(div_value,ftl.optimized_params.first)) : pages_in_block.size();
+    }
+    return block_score;
+}
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    config.physical_blocks = argc > 1 ? atoi(argv[1]) : 2048;
+    config.logical_blocks = argc > 2 ? atoi(argv[2]) : 1792;
+    config.pages_per_block = argc > 3 ? atoi(argv[3]) : 64;
+    int number_of_gcs = argc > 4 ? atoi(argv[4]) : 20;
+    config.page_size = 4096;
+    config.number_of_pages = config.physicalPages() * 4;
+
+    cout << "Greedy LookAhead GC benchmark: T=" << config.physical_blocks << " U=" << config.logical_blocks
+         << " Z=" << config.pages_per_block << " (" << config.logicalPages() << " logical pages)" << endl;
+
+    /* the generator is left with its fixed initial seed, so every run scores the same blocks */
+    RandomGenerator rng;
+    unsigned int* writing_sequence = generateUniformlyDistributedWriteSequence(config, &rng);
+    FTL ftl(config);
+    LookaheadScorer scorer(writing_sequence, config.number_of_pages, config.logicalPages(), config.physicalPages(),
+                           ftl.optimized_params.first);
+    ftl.scorer = &scorer;
+    char data[1] = {0};
+    for (unsigned long long i = 0; i < 2ULL * config.logicalPages(); i++) {
+        ftl.write(data, rng.uniform(config.logicalPages()), GREEDY);
+    }
+
+    double scan_ns = 0, closed_form_ns = 0;
+    long long candidates = 0;
+    int gcs = 0;
+    for (unsigned long long i = 0; i < config.number_of_pages && gcs < number_of_gcs; i++) {
+        if (ftl.freeList.empty()) {
+            ftl.updateMinValid();
+            vector<int> blocks_to_score;
+            for (int block_num : ftl.V[ftl.Y]) {
+                blocks_to_score.push_back(block_num);
+            }
+
+            auto start = chrono::steady_clock::now();
+            vector<double> scan_scores;
+            for (int block_num : blocks_to_score) {
+                scan_scores.push_back(linearScanBlockScore(ftl, block_num, i, writing_sequence));
+            }
+            auto middle = chrono::steady_clock::now();
+            vector<double> closed_form_scores;
+            for (int block_num : blocks_to_score) {
+                closed_form_scores.push_back(ftl.getBlockScore(block_num, i, writing_sequence));
+            }
+            auto end = chrono::steady_clock::now();
+
+            for (unsigned int k = 0; k < scan_scores.size(); k++) {
+                if (fabs(scan_scores[k] - closed_form_scores[k]) > 1e-9 * max(1.0, fabs(scan_scores[k]))) {
+                    cerr << "Error! block scores do not match at write " << i << endl;
+                    return 1;
+                }
+            }
+            scan_ns += chrono::duration<double, nano>(middle - start).count();
+            closed_form_ns += chrono::duration<double, nano>(end - middle).count();
+            candidates += blocks_to_score.size();
+            gcs++;
+        }
+        ftl.write(data, writing_sequence[i], GREEDY_LOOKAHEAD, writing_sequence, i);
+    }
+
+    cout << "GCs measured: " << gcs << ", candidate blocks per GC: " << (double)candidates / gcs << endl;
+    cout << "original score (sequence scan, linear lookup):\t" << scan_ns / gcs / 1e6 << " ms per GC" << endl;
+    cout << "closed form score (LookaheadScorer):\t\t" << closed_form_ns / gcs / 1e6 << " ms per GC" << endl;
+    cout << "speedup of the closed form:\t\t\t" << scan_ns / closed_form_ns << "x" << endl;
+
+    delete [] writing_sequence;
+    return 0;
+}
@@ -0,0 +1,334 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+/*
+ *	End to end regression harness. We run the simulator on a fixed matrix of scenarios (the README examples, the
+ *	online cost-benefit policies and a few larger memories), every one with a fixed seed, and check that the number of erases and the write
+ *	amplification of every scenario are exactly the golden results (bench/regression_golden.csv), so an
+ *	optimization can't change the answers of the simulator unnoticed. The results are read from the JSON report
+ *	of the run (--report).
+ *	For every scenario we also record the wall time and the peak RSS of the simulator process, and the throughput
+ *	of its simulation loop (writes/sec). Given a baseline (the results of an earlier run, saved with --save) we flag
+ *	the scenarios whose throughput dropped by more than the threshold. Only the larger scenarios are checked, the
+ *	simulation loop of the README examples is too short to time reliably.
+ *	The harness exits with 1 if a scenario failed, its results don't match or its throughput regressed.
+ *
+ *	usage: ./regression simulator [--golden=file] [--save=file] [--baseline=file] [--threshold=percent]
+ *	                              [--update-golden]
+ *	--update-golden writes the results of this run as the new golden results (after a change that is meant to
+ *	change them).
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DEFAULT_GOLDEN_FILE "bench/regression_golden.csv"
+
+/* the largest drop of the throughput from the baseline (in percent) that is not a regression */
+#define DEFAULT_THRESHOLD 10
+
+using namespace std;
+
+class Scenario {
+public:
+    const char* name;
+    /* the answers to the interactive questions of the simulator (hot/cold parameters, window size, generations) */
+    const char* input;
+    /* whether the throughput is compared with the baseline */
+    bool check_throughput;
+    vector<const char*> args;
+};
+
+static const Scenario scenarios[] = {
+        {"greedy", "", false,
+                {"--seed=1", "64", "50", "32", "4096", "100000", "window_off", "uniform", "greedy"}},
+        {"greedy_lookahead", "", false,
+                {"--seed=1", "64", "50", "32", "4096", "100000", "window_off", "uniform", "greedy_lookahead"}},
+        {"generational", "2\n", false,
+                {"--seed=1", "64", "52", "32", "4096", "100000", "window_off", "uniform", "generational"}},
+        {"generational_of", "0\n", false,
+                {"--seed=1", "64", "52", "32", "4096", "100000", "window_off", "uniform", "generational"}},
+        {"hot_cold_generational_window", "5\n0.9\n50000\n0\n", false,
+                {"--seed=1", "64", "52", "32", "4096", "100000", "window_on", "hot_cold", "generational"}},
+        {"greedy_lookahead_window", "2000\n", false,
+                {"--seed=1", "64", "55", "32", "4096", "10000", "window_on", "uniform", "greedy_lookahead"}},
+        {"cost_benefit_hot_cold", "5\n0.9\n", false,
+                {"--seed=1", "64", "52", "32", "4096", "100000", "window_off", "hot_cold", "cost_benefit"}},
+        {"cat_hot_cold", "5\n0.9\n", false,
+                {"--seed=1", "64", "52", "32", "4096", "100000", "window_off", "hot_cold", "cat"}},
+        {"greedy_large", "", true,
+                {"--seed=1", "1024", "896", "64", "4096", "2000000", "window_off", "uniform", "greedy"}},
+        {"greedy_lookahead_large", "", true,
+                {"--seed=1", "1024", "896", "64", "4096", "1000000", "window_off", "uniform", "greedy_lookahead"}},
+        {"greedy_lookahead_large_stream", "", true,
+                {"--seed=1", "--stream", "1024", "896", "64", "4096", "1000000", "window_off", "uniform",
+                 "greedy_lookahead"}},
+        {"generational_of_large", "0\n", true,
+                {"--seed=1", "1024", "896", "64", "4096", "1000000", "window_off", "uniform", "generational"}},
+};
+
+class RunResult {
+public:
+    bool ok;
+    /* as printed in the report, so they are compared exactly */
+    string erases;
+    string write_amplification;
+    double wall_seconds;
+    long peak_rss_kb;
+    double writes_per_second;
+
+    RunResult() : ok(false), wall_seconds(0), peak_rss_kb(0), writes_per_second(0) {}
+};
+
+/* the value of a top level field of the JSON report (numbers only) */
+static string reportField(const string& report, const char* key) {
+    string pattern = string("\"") + key + "\": ";
+    size_t begin = report.find(pattern);
+    if (begin == string::npos) {
+        return "";
+    }
+    begin += pattern.size();
+    size_t end = report.find_first_of(",\n}", begin);
+    return report.substr(begin, end - begin);
+}
+
+/* run the simulator on a scenario with its output discarded, and collect the results from its report */
+static RunResult runScenario(const char* simulator, const Scenario& scenario) {
+    RunResult result;
+    char report_path[] = "/tmp/flashgc_regression_XXXXXX";
+    int report_fd = mkstemp(report_path);
+    if (report_fd < 0) {
+        cerr << "Error! Could not create a report file." << endl;
+        exit(-1);
+    }
+    close(report_fd);
+    string report_flag = string("--report=") + report_path;
+    vector<char*> argv;
+    argv.push_back((char*)simulator);
+    argv.push_back((char*)report_flag.c_str());
+    for (const char* arg : scenario.args) {
+        argv.push_back((char*)arg);
+    }
+    argv.push_back(nullptr);
+
+    int input[2];
+    if (pipe(input) != 0) {
+        cerr << "Error! Could not create a pipe." << endl;
+        exit(-1);
+    }
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        cerr << "Error! Could not run " << simulator << "." << endl;
+        exit(-1);
+    }
+    if (pid == 0) {
+        dup2(input[0], 0);
+        close(input[0]);
+        close(input[1]);
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, 1);
+        execv(simulator, argv.data());
+        perror(simulator);
+        _exit(127);
+    }
+    close(input[0]);
+    /* the answers are a few bytes, so they fit in the pipe before the simulator reads them */
+    if (write(input[1], scenario.input, strlen(scenario.input)) != (ssize_t)strlen(scenario.input)) {
+        cerr << "Error! Could not write the input of scenario " << scenario.name << "." << endl;
+    }
+    close(input[1]);
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid) {
+        cerr << "Error! Could not run " << simulator << "." << endl;
+        exit(-1);
+    }
+    result.wall_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.peak_rss_kb = usage.ru_maxrss;
+
+    ifstream report_file(report_path);
+    stringstream report;
+    report << report_file.rdbuf();
+    unlink(report_path);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return result;
+    }
+    result.erases = reportField(report.str(), "erases");
+    result.write_amplification = reportField(report.str(), "write_amplification");
+    result.writes_per_second = atof(reportField(report.str(), "writes_per_second").c_str());
+    result.ok = !result.erases.empty() && !result.write_amplification.empty();
+    return result;
+}
+
+/* the lines of a CSV file (without the header) split into fields, by their first field */
+static map<string, vector<string>> readCsv(const char* path) {
+    map<string, vector<string>> rows;
+    ifstream file(path);
+    if (!file) {
+        cerr << "Error! Could not open " << path << "." << endl;
+        exit(-1);
+    }
+    string line;
+    getline(file, line);
+    while (getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        vector<string> fields;
+        stringstream stream(line);
+        string field;
+        while (getline(stream, field, ',')) {
+            fields.push_back(field);
+        }
+        rows[fields[0]] = fields;
+    }
+    return rows;
+}
+
+static void printUsage() {
+    cerr << "usage: ./regression simulator [--golden=file] [--save=file] [--baseline=file] [--threshold=percent] "
+            "[--update-golden]" << endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    const char* simulator = argv[1];
+    const char* golden_path = DEFAULT_GOLDEN_FILE;
+    const char* save_path = nullptr;
+    const char* baseline_path = nullptr;
+    double threshold = DEFAULT_THRESHOLD;
+    bool update_golden = false;
+    for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "--golden=", 9) == 0) {
+            golden_path = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--save=", 7) == 0) {
+            save_path = argv[i] + 7;
+        }
+        else if (strncmp(argv[i], "--baseline=", 11) == 0) {
+            baseline_path = argv[i] + 11;
+        }
+        else if (strncmp(argv[i], "--threshold=", 12) == 0) {
+            char* end;
+            threshold = strtod(argv[i] + 12, &end);
+            if (*end != '\0' || threshold < 0) {
+                cerr << "Error! Invalid threshold " << argv[i] + 12 << "." << endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--update-golden") == 0) {
+            update_golden = true;
+        }
+        else {
+            cerr << "Error! Unknown flag " << argv[i] << "." << endl;
+            printUsage();
+            return 1;
+        }
+    }
+    map<string, vector<string>> golden;
+    if (!update_golden) {
+        golden = readCsv(golden_path);
+    }
+    map<string, vector<string>> baseline;
+    if (baseline_path) {
+        baseline = readCsv(baseline_path);
+    }
+
+    cout << left << setw(31) << "scenario" << right << setw(9) << "erases" << setw(10) << "WA" << setw(10) << "golden"
+         << setw(10) << "wall (s)" << setw(10) << "RSS (MB)" << setw(14) << "writes/sec" << setw(16) << "vs baseline"
+         << endl;
+    vector<RunResult> results;
+    int failures = 0;
+    for (const Scenario& scenario : scenarios) {
+        RunResult result = runScenario(simulator, scenario);
+        results.push_back(result);
+        cout << left << setw(31) << scenario.name << right;
+        if (!result.ok) {
+            cout << "  FAILED to run" << endl;
+            failures++;
+            continue;
+        }
+        string status = "ok";
+        if (!update_golden) {
+            auto expected = golden.find(scenario.name);
+            if (expected == golden.end() || expected->second.size() < 3) {
+                status = "missing";
+                failures++;
+            }
+            else if (expected->second[1] != result.erases || expected->second[2] != result.write_amplification) {
+                status = "MISMATCH";
+                failures++;
+            }
+        }
+        string change = "-";
+        auto base = baseline.find(scenario.name);
+        if (base != baseline.end() && base->second.size() >= 6) {
+            double base_writes_per_second = atof(base->second[5].c_str());
+            if (base_writes_per_second > 0) {
+                double percent = (result.writes_per_second - base_writes_per_second) / base_writes_per_second * 100;
+                stringstream stream;
+                stream << showpos << fixed << setprecision(1) << percent << "%";
+                change = stream.str();
+                if (scenario.check_throughput && percent < -threshold) {
+                    change += " SLOWER";
+                    failures++;
+                }
+            }
+        }
+        cout << setw(9) << result.erases << setw(10) << result.write_amplification << setw(10) << status
+             << fixed << setprecision(2) << setw(10) << result.wall_seconds << setprecision(1) << setw(10)
+             << result.peak_rss_kb / 1024.0 << setprecision(0) << setw(14) << result.writes_per_second
+             << setw(16) << change << endl;
+        if (status == "MISMATCH") {
+            cout << "    expected " << golden[scenario.name][1] << " erases, write amplification "
+                 << golden[scenario.name][2] << endl;
+        }
+    }
+
+    if (save_path || update_golden) {
+        const char* path = update_golden ? golden_path : save_path;
+        ofstream out(path);
+        out << (update_golden ? "scenario,erases,write_amplification" :
+                "scenario,erases,write_amplification,wall_seconds,peak_rss_kb,writes_per_second") << endl;
+        for (unsigned int i = 0; i < results.size(); i++) {
+            out << scenarios[i].name << "," << results[i].erases << "," << results[i].write_amplification;
+            if (!update_golden) {
+                out << "," << results[i].wall_seconds << "," << results[i].peak_rss_kb << ","
+                    << fixed << setprecision(0) << results[i].writes_per_second << defaultfloat;
+            }
+            out << endl;
+        }
+        if (!out) {
+            cerr << "Error! Could not write " << path << "." << endl;
+            return 1;
+        }
+    }
+
+    if (failures) {
+        cout << failures << " scenario(s) failed, did not match or regressed." << endl;
+        return 1;
+    }
+    cout << "All scenarios passed." << endl;
+    return 0;
+}
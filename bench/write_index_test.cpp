@@ -0,0 +1,82 @@
+/*
+ *	Created by Eyal Lotan and Dor Sura.
+ */
+
+/*
+ *	Test that the write index of the look ahead GC is not truncated past 2^32 writes.
+ *	We bring two FTLs to the same steady state and run the same writes on both with a streamed LookaheadScorer,
+ *	once at write indices 0..TEST_WRITES-1 and once at indices that cross 2^32 halfway. Only the indices differ,
+ *	so both runs must pick the same victims, and end with the same number of erases and the same mapping table.
+ *
+ *	usage: ./write_index_test
+ */
+
+#include <iostream>
+#include "../AlgoRunner.h"
+
+#define TEST_WRITES 20000
+
+/* the first write index of the second run, TEST_WRITES/2 writes before 2^32 */
+#define CROSSING_BASE ((1ULL << 32) - TEST_WRITES / 2)
+
+/* the number of writes the streamed scorer keeps (a power of 2 above the scan horizon) */
+#define TEST_BUFFER_CAPACITY 1024
+
+void printHelp() {}
+
+/* run the writes of sequence at write indices base..base+TEST_WRITES-1, appending every write to the scorer
+ * horizon writes before it is written (as SequenceStream does)
+ */
+static void run(FTL* ftl, const SimConfig& config, const vector<unsigned int>& sequence, unsigned long long base) {
+    unsigned long long horizon = config.physicalPages();
+    LookaheadScorer scorer(base + TEST_WRITES, config.logicalPages(), horizon, ftl->optimized_params.first,
+                           TEST_BUFFER_CAPACITY);
+    scorer.startAt(base);
+    ftl->scorer = &scorer;
+    char data[1] = {0};
+    unsigned long long appended = 0;
+    for (unsigned long long i = 0; i < TEST_WRITES; i++) {
+        for (; appended < TEST_WRITES && appended <= i + horizon; appended++) {
+            scorer.append(base + appended, sequence[appended]);
+        }
+        ftl->write(data, sequence[i], GREEDY_LOOKAHEAD, nullptr, base + i);
+    }
+    ftl->scorer = nullptr;
+}
+
+int main() {
+    SimConfig config(16, 12, 8, 4096, CROSSING_BASE + TEST_WRITES);
+    RandomGenerator rng;
+    vector<unsigned int> warmup, sequence;
+    for (unsigned int i = 0; i < 2 * config.logicalPages(); i++) {
+        warmup.push_back(rng.uniform(config.logicalPages()));
+    }
+    for (unsigned int i = 0; i < TEST_WRITES; i++) {
+        sequence.push_back(rng.uniform(config.logicalPages()));
+    }
+
+    FTL reference(config), crossing(config);
+    char data[1] = {0};
+    for (unsigned int lpn : warmup) {
+        reference.write(data, lpn, GREEDY);
+        crossing.write(data, lpn, GREEDY);
+    }
+    long long warmup_erases = reference.erases;
+    run(&reference, config, sequence, 0);
+    run(&crossing, config, sequence, CROSSING_BASE);
+
+    cout << "erases after the warmup: " << warmup_erases << ", from write 0: " << reference.erases
+         << ", across 2^32: " << crossing.erases << endl;
+    if (reference.erases != crossing.erases) {
+        cerr << "Error! the runs made a different number of erases" << endl;
+        return 1;
+    }
+    for (unsigned int lpn = 0; lpn < config.logicalPages(); lpn++) {
+        if (reference.mappingTable[lpn] != crossing.mappingTable[lpn]) {
+            cerr << "Error! the mapping tables differ at logical page " << lpn << endl;
+            return 1;
+        }
+    }
+    cout << "PASS" << endl;
+    return 0;
+}
@@ -1,7 +1,12 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <climits>
+#include <cmath>
+#include <cerrno>
+#include <thread>
 #include "AlgoRunner.h"
+#include "Sweep.h"
 using namespace std;
 
 /* get parameters from command line
@@ -14,6 +19,23 @@ using namespace std;
  * #7:DATA_DISTRIBUTION
  * #8:ALGORITHM
  * #9:optional parameter - filename to redirect output to
+ * optional flags (anywhere in the command line):
+ * --payload=none|real
+ * --candidate-buckets=k
+ * --candidate-budget=B
+ * --threads=N
+ * --stream[=chunk_size]
+ * --pipeline
+ * --trace=trace_file, --trace-format=msr|blkparse|binary, --trace-lba=fold|dense (with the trace distribution)
+ * --record=sequence_file
+ * --warmup=N, --warmup-tolerance=x, --warmup-cap=N
+ * --save-steady-state=checkpoint_file, --load-steady-state=checkpoint_file
+ * --checkpoint=checkpoint_file, --checkpoint-every=N, --resume
+ * --telemetry=telemetry_file, --telemetry-every=K, --telemetry-by=erases|writes, --telemetry-format=csv|binary
+ * --report=report_file
+ * --seed=S
+ * --zipf-theta=theta (with the zipf and ycsb distributions), --tiers=list (with the tiers distribution)
+ * --sweep=grid_file (instead of the positional parameters, optionally followed by a filename to redirect output to)
  */
 
 /**
@@ -32,8 +54,14 @@ void printHelp()
             "7. Data distribution.\n"
             "8. GC algorithm.\n"
             "9. Optional parameter: Filename to redirect output to." << endl;
-    cout << "For data distribution parameter choose between uniform or hot_cold. If you choose hot/cold distribution, " << endl
-         << "you will be asked to choose the hot page percentage and the probability for a hot page." << endl;
+    cout << "For data distribution parameter choose between uniform, hot_cold, tiers, zipf, ycsb, tpcc or trace. " << endl
+         << "If you choose hot/cold distribution, you will be asked to choose the hot page percentage and the " << endl
+         << "probability for a hot page." << endl
+         << "tiers splits the pages into the tiers given with --tiers. zipf writes page r with probability " << endl
+         << "proportional to 1/(r+1)^theta, and ycsb is zipf over the pages in a random order (YCSB's scrambled " << endl
+         << "zipfian). tpcc is TPC-C's NURand non uniform random over the logical pages." << endl
+         << "If you choose trace, the writes of the block I/O trace given with --trace are replayed (N=0 replays the " << endl
+         << "whole trace once)." << endl;
     cout << "For window flag choose between window_on or window_off. If you choose window_on you will be asked to " << endl
          << "choose the window size. Window size should be between 0 and N." << endl;
     cout << "For GC algorithm choose between the following:\n"
@@ -42,10 +70,394 @@ void printHelp()
             "3. generational. If you choose this option you will be prompt to choose the number of generations. " << endl
             << "Make sure that the number of generations is between 1 and T-U (this will be enforced by the simulator)." << endl
             << "If you choose number of generations to be 0, the simulator will choose the number of generations using " << endl
-            << "a heurisitc function." << endl;
+            << "a heurisitc function." << endl
+            << "4. cost_benefit. no future knowledge: the GC victim is the block with the highest age*(1-u)/2u, where " << endl
+            << "u is the fraction of valid pages in the block and age is the number of host writes since the block " << endl
+            << "was last modified." << endl
+            << "5. cat (cost-age-times). like cost_benefit, and the score is also divided by the number of times the " << endl
+            << "block was erased, to level the wear." << endl;
+    cout << "Optional flags:\n"
+            "--payload=none|real - none (default) simulates page metadata only. real keeps the data of all pages in " << endl
+            << "a backing store and validates data integrity at the end of the simulation." << endl
+            << "--candidate-buckets=k - look ahead algorithms consider the blocks with Y..Y+k valid pages, where Y is " << endl
+            << "the minimal number of valid pages. by default the GC victim is taken from Y only, and the writing " << endl
+            << "assignment uses Y..Y+1 (uniform) or all the buckets (hot_cold)." << endl
+            << "--candidate-budget=B - score at most B of these blocks (default: 0, no limit)." << endl
+            << "--threads=N - generate the writing sequence and score candidate blocks on N threads (default: 1). " << endl
+            << "results do not depend on N." << endl
+            << "--seed=S - seed the random state with S, to repeat a run. by default a random seed is picked and " << endl
+            << "printed." << endl
+            << "--zipf-theta=theta - the skew of the zipf and ycsb distributions (default: " << DEFAULT_ZIPF_THETA
+            << ")." << endl
+            << "--tiers=percentage:probability,... - the tiers of the tiers distribution, from page 0 on: the " << endl
+            << "percentage of the logical pages in the tier and the probability of a write to it, e.g. hot, warm " << endl
+            << "and cold pages with --tiers=10:0.6,30:0.3,60:0.1. the percentages must sum up to 100 and the " << endl
+            << "probabilities to 1." << endl
+            << "--stream[=chunk_size] - generate the writing sequence in chunks (default: " << DEFAULT_STREAM_CHUNK
+            << " writes) while it is written, and only keep the lookahead the algorithm needs, so the memory does " << endl
+            << "not depend on N. not supported by writing_assignment." << endl
+            << "--pipeline - stream the writing sequence (see --stream), and generate it on a separate thread while " << endl
+            << "it is simulated. results are the same as without the pipeline." << endl
+            << "--trace=trace_file - the block I/O trace to replay with the trace distribution." << endl
+            << "--trace-format=msr|blkparse|binary - msr (default) is the MSR Cambridge / SNIA CSV format, blkparse " << endl
+            << "is the text output of blkparse. writes are split into page_size pages. binary is a sequence file " << endl
+            << "written with --record (its U*Z must match the simulation)." << endl
+            << "--trace-lba=fold|dense - fold (default) maps page p to logical page p mod U*Z. dense numbers the " << endl
+            << "distinct pages in the order they are first written." << endl
+            << "--record=sequence_file - don't simulate, write the writing sequence (of any distribution, including " << endl
+            << "a trace) to a compact binary sequence file, to replay it later with --trace-format=binary." << endl
+            << "--warmup=N - warm up to the steady state with N random greedy writes. by default the warmup fills " << endl
+            << "the logical space once, and then goes on until the write amplification of a window of erases (T, " << endl
+            << "and at least " << WARMUP_MIN_WINDOW_ERASES << ") is within the tolerance of the previous window "
+            << WARMUP_STABLE_WINDOWS << " times in a row." << endl
+            << "--warmup-tolerance=x - the relative change of the write amplification that counts as converged " << endl
+            << "(default: " << DEFAULT_WARMUP_TOLERANCE << ")." << endl
+            << "--warmup-cap=N - the most writes of the adaptive warmup (default: no limit, but at most "
+            << WARMUP_MAX_WINDOWS << " windows)." << endl
+            << "--save-steady-state=checkpoint_file - save the state of the simulation after the steady state " << endl
+            << "warmup to a checkpoint file." << endl
+            << "--load-steady-state=checkpoint_file - load the steady state from a checkpoint file instead of warming " << endl
+            << "up. the checkpoint must have been saved with the same T, U, Z, page size, payload mode, seed and " << endl
+            << "distribution, and the run is the same as if it warmed up by itself." << endl
+            << "--checkpoint=checkpoint_file - save a checkpoint of the simulation to checkpoint_file every " << endl
+            << "--checkpoint-every=N writes (default: " << DEFAULT_CHECKPOINT_INTERVAL << "). the previous checkpoint "
+            << "is replaced only once the new one is complete." << endl
+            << "--resume - go on from the checkpoint in checkpoint_file (if it exists) instead of starting over. " << endl
+            << "the simulation must have the same parameters, and the results are the same as if it was never " << endl
+            << "stopped. without --seed the seed of the checkpoint is used." << endl
+            << "--telemetry=telemetry_file - record a time series of the simulation: the cumulative write " << endl
+            << "amplification, Y, the free list length and the V bucket sizes, every --telemetry-every=K erases " << endl
+            << "(default: T) or host writes (default: T*Z) as set by --telemetry-by=erases|writes (default: erases)." << endl
+            << "--telemetry-format=csv|binary - the format of the telemetry file (default: csv). See Telemetry.h." << endl
+            << "--report=report_file - time the phases of the simulation (including the victim selection and the " << endl
+            << "relocation of every erase) and write a JSON report of the run to report_file: the parameters, the " << endl
+            << "results, writes/sec, the time of every phase and the number of blocks scored." << endl
+            << "--sweep=grid_file - run a parameter sweep instead of a single simulation: all the combinations of the " << endl
+            << "parameters in grid_file run in parallel on N threads (default: all cores), and one CSV row is written " << endl
+            << "per run. Use: ./Simulator --sweep=grid_file [--threads=N] [output file]. See Sweep.h for the grid format." << endl;
+}
+
+/* the optional --flags of a simulation */
+struct RunFlags {
+    PayloadMode payload_mode;
+    int candidate_buckets;
+    int candidate_budget;
+    /* 0 if not given */
+    int threads;
+    const char* sweep_file;
+    /* the sequence file to record the writing sequence to, or nullptr to simulate */
+    const char* record_file;
+    /* the JSON run report file, or nullptr */
+    const char* report_file;
+    /* steady state checkpoint files, or nullptr */
+    const char* load_steady_state;
+    const char* save_steady_state;
+    TelemetryOptions telemetry;
+    /* the running checkpoint file (or nullptr), the writes between two checkpoints and whether to resume */
+    const char* checkpoint;
+    unsigned long long checkpoint_interval;
+    bool resume;
+    /* 0 if the writing sequence is not streamed */
+    int stream_chunk;
+    bool pipeline;
+    TraceOptions trace;
+    SkewOptions skew;
+    WarmupOptions warmup;
+    bool seeded;
+    unsigned long long seed;
+
+    RunFlags() : payload_mode(NO_PAYLOAD), candidate_buckets(DEFAULT_CANDIDATE_BUCKETS),
+                 candidate_budget(NO_CANDIDATE_BUDGET), threads(0), sweep_file(nullptr), record_file(nullptr),
+                 report_file(nullptr), load_steady_state(nullptr), save_steady_state(nullptr), checkpoint(nullptr),
+                 checkpoint_interval(DEFAULT_CHECKPOINT_INTERVAL), resume(false), stream_chunk(0), pipeline(false), seeded(false), seed(0) {}
+};
+
+/**
+ * Parse a non-negative integer flag value. Returns false if the value is invalid.
+ */
+bool parseNonNegative(const char* value, int* result)
+{
+    char* end;
+    long parsed = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || parsed < 0 || parsed > INT_MAX) {
+        return false;
+    }
+    *result = (int)parsed;
+    return true;
+}
+
+/**
+ * Parse an unsigned 64 bit flag value. Returns false if the value is invalid.
+ */
+bool parseUnsigned64(const char* value, unsigned long long* result)
+{
+    char* end;
+    errno = 0;
+    unsigned long long parsed = strtoull(value, &end, 10);
+    if (*value < '0' || *value > '9' || *end != '\0' || errno == ERANGE) {
+        return false;
+    }
+    *result = parsed;
+    return true;
+}
+
+/**
+ * Parse the --tiers list (percentage:probability,...). Returns false if the list is invalid.
+ */
+bool parseTiers(const char* value, vector<Tier>* tiers)
+{
+    double percentages = 0, probabilities = 0;
+    tiers->clear();
+    while (true) {
+        Tier tier;
+        char* end;
+        tier.page_percentage = strtod(value, &end);
+        if (end == value || *end != ':' || !(tier.page_percentage > 0)) {
+            return false;
+        }
+        value = end + 1;
+        tier.probability = strtod(value, &end);
+        if (end == value || (*end != ',' && *end != '\0') || !(tier.probability >= 0)) {
+            return false;
+        }
+        tiers->push_back(tier);
+        percentages += tier.page_percentage;
+        probabilities += tier.probability;
+        if (*end == '\0') {
+            break;
+        }
+        value = end + 1;
+    }
+    return fabs(percentages - 100) < 1e-6 && fabs(probabilities - 1) < 1e-6;
+}
+
+/**
+ * Move the optional --flags out of argv, so only the positional parameters are left.
+ * Returns false on an invalid flag.
+ */
+bool parseFlags(int* argc, char** argv, RunFlags* flags)
+{
+    int positional = 1;
+    for (int i = 1; i < *argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0 || strcmp(argv[i], "--help") == 0) {
+            argv[positional++] = argv[i];
+            continue;
+        }
+        if (strncmp(argv[i], "--payload=", strlen("--payload=")) == 0) {
+            flags->payload_mode = payloadModeStringToEnum(argv[i] + strlen("--payload="));
+            if (flags->payload_mode == INVALID_PAYLOAD_MODE) {
+                cerr << "Invalid Payload Mode Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--candidate-buckets=", strlen("--candidate-buckets=")) == 0) {
+            if (!parseNonNegative(argv[i] + strlen("--candidate-buckets="), &flags->candidate_buckets)) {
+                cerr << "Invalid Candidate Buckets Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--candidate-budget=", strlen("--candidate-budget=")) == 0) {
+            if (!parseNonNegative(argv[i] + strlen("--candidate-budget="), &flags->candidate_budget)) {
+                cerr << "Invalid Candidate Budget Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--threads=", strlen("--threads=")) == 0) {
+            if (!parseNonNegative(argv[i] + strlen("--threads="), &flags->threads) || flags->threads == 0) {
+                cerr << "Invalid Number of Threads Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "--stream") == 0) {
+            flags->stream_chunk = DEFAULT_STREAM_CHUNK;
+            continue;
+        }
+        if (strncmp(argv[i], "--stream=", strlen("--stream=")) == 0) {
+            if (!parseNonNegative(argv[i] + strlen("--stream="), &flags->stream_chunk) || flags->stream_chunk == 0) {
+                cerr << "Invalid Stream Chunk Size Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--trace=", strlen("--trace=")) == 0) {
+            flags->trace.path = argv[i] + strlen("--trace=");
+            continue;
+        }
+        if (strncmp(argv[i], "--trace-format=", strlen("--trace-format=")) == 0) {
+            flags->trace.format = traceFormatStringToEnum(argv[i] + strlen("--trace-format="));
+            if (flags->trace.format == INVALID_TRACE_FORMAT) {
+                cerr << "Invalid Trace Format Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--trace-lba=", strlen("--trace-lba=")) == 0) {
+            flags->trace.lba_mapping = lbaMappingStringToEnum(argv[i] + strlen("--trace-lba="));
+            if (flags->trace.lba_mapping == INVALID_LBA_MAPPING) {
+                cerr << "Invalid Trace LBA Mapping Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--seed=", strlen("--seed=")) == 0) {
+            if (!parseUnsigned64(argv[i] + strlen("--seed="), &flags->seed)) {
+                cerr << "Invalid Seed Parameter!" << endl;
+                return false;
+            }
+            flags->seeded = true;
+            continue;
+        }
+        if (strncmp(argv[i], "--zipf-theta=", strlen("--zipf-theta=")) == 0) {
+            char* end;
+            flags->skew.zipf_theta = strtod(argv[i] + strlen("--zipf-theta="), &end);
+            if (end == argv[i] + strlen("--zipf-theta=") || *end != '\0' || !(flags->skew.zipf_theta >= 0)) {
+                cerr << "Invalid Zipf Theta Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--tiers=", strlen("--tiers=")) == 0) {
+            if (!parseTiers(argv[i] + strlen("--tiers="), &flags->skew.tiers)) {
+                cerr << "Invalid Tiers Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "--pipeline") == 0) {
+            flags->pipeline = true;
+            continue;
+        }
+        if (strncmp(argv[i], "--record=", strlen("--record=")) == 0) {
+            flags->record_file = argv[i] + strlen("--record=");
+            continue;
+        }
+        if (strncmp(argv[i], "--warmup=", strlen("--warmup=")) == 0) {
+            if (!parseUnsigned64(argv[i] + strlen("--warmup="), &flags->warmup.writes) || flags->warmup.writes == 0) {
+                cerr << "Invalid Warmup Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--warmup-tolerance=", strlen("--warmup-tolerance=")) == 0) {
+            char* end;
+            flags->warmup.tolerance = strtod(argv[i] + strlen("--warmup-tolerance="), &end);
+            if (end == argv[i] + strlen("--warmup-tolerance=") || *end != '\0' || !(flags->warmup.tolerance > 0)) {
+                cerr << "Invalid Warmup Tolerance Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--warmup-cap=", strlen("--warmup-cap=")) == 0) {
+            if (!parseUnsigned64(argv[i] + strlen("--warmup-cap="), &flags->warmup.max_writes) ||
+                flags->warmup.max_writes == 0) {
+                cerr << "Invalid Warmup Cap Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--save-steady-state=", strlen("--save-steady-state=")) == 0) {
+            flags->save_steady_state = argv[i] + strlen("--save-steady-state=");
+            continue;
+        }
+        if (strncmp(argv[i], "--load-steady-state=", strlen("--load-steady-state=")) == 0) {
+            flags->load_steady_state = argv[i] + strlen("--load-steady-state=");
+            continue;
+        }
+        if (strncmp(argv[i], "--checkpoint=", strlen("--checkpoint=")) == 0) {
+            flags->checkpoint = argv[i] + strlen("--checkpoint=");
+            continue;
+        }
+        if (strncmp(argv[i], "--checkpoint-every=", strlen("--checkpoint-every=")) == 0) {
+            if (!parseUnsigned64(argv[i] + strlen("--checkpoint-every="), &flags->checkpoint_interval) ||
+                flags->checkpoint_interval == 0) {
+                cerr << "Invalid Checkpoint Interval Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "--resume") == 0) {
+            flags->resume = true;
+            continue;
+        }
+        if (strncmp(argv[i], "--report=", strlen("--report=")) == 0) {
+            flags->report_file = argv[i] + strlen("--report=");
+            continue;
+        }
+        if (strncmp(argv[i], "--telemetry=", strlen("--telemetry=")) == 0) {
+            flags->telemetry.path = argv[i] + strlen("--telemetry=");
+            continue;
+        }
+        if (strncmp(argv[i], "--telemetry-every=", strlen("--telemetry-every=")) == 0) {
+            if (!parseUnsigned64(argv[i] + strlen("--telemetry-every="), &flags->telemetry.every) ||
+                flags->telemetry.every == 0) {
+                cerr << "Invalid Telemetry Interval Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--telemetry-by=", strlen("--telemetry-by=")) == 0) {
+            flags->telemetry.unit = telemetryUnitStringToEnum(argv[i] + strlen("--telemetry-by="));
+            if (flags->telemetry.unit == INVALID_TELEMETRY_UNIT) {
+                cerr << "Invalid Telemetry Unit Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--telemetry-format=", strlen("--telemetry-format=")) == 0) {
+            flags->telemetry.format = telemetryFormatStringToEnum(argv[i] + strlen("--telemetry-format="));
+            if (flags->telemetry.format == INVALID_TELEMETRY_FORMAT) {
+                cerr << "Invalid Telemetry Format Parameter!" << endl;
+                return false;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--sweep=", strlen("--sweep=")) == 0) {
+            flags->sweep_file = argv[i] + strlen("--sweep=");
+            continue;
+        }
+        cerr << "Unknown flag " << argv[i] << "!" << endl;
+        return false;
+    }
+    if (flags->resume && !flags->checkpoint) {
+        cerr << "--resume must be used with --checkpoint=checkpoint_file!" << endl;
+        return false;
+    }
+    if (flags->pipeline && flags->stream_chunk == 0) {
+        flags->stream_chunk = DEFAULT_STREAM_CHUNK;
+    }
+    *argc = positional;
+    return true;
 }
 
 int main(int argc, char** argv) {
+	RunFlags flags;
+	if (!parseFlags(&argc, argv, &flags)) {
+		printHelp();
+		return -1;
+	}
+
+	if (flags.sweep_file) {
+		if (argc > 2) {
+			cerr << "Invalid number of arguments!" << endl;
+			printHelp();
+			return -1;
+		}
+		Sweep sweep(flags.sweep_file);
+		int threads = flags.threads ? flags.threads : std::max(1u, std::thread::hardware_concurrency());
+		if (argc == 2) {
+			ofstream out(argv[1], ios::app);
+			sweep.run(threads, out);
+		}
+		else {
+			sweep.run(threads, cout);
+		}
+		return 0;
+	}
+
 	if (argc < 9) {
 	    if (argc == 2 && strcmp("--help", argv[1]) == 0){
 	        printHelp();
@@ -62,11 +474,7 @@ int main(int argc, char** argv) {
 		freopen(output_file, "a", stdout);
 	}
 
-	PHYSICAL_BLOCK_NUMBER = atoi(argv[1]);
-	LOGICAL_BLOCK_NUMBER = atoi(argv[2]);
-	PAGES_PER_BLOCK = atoi(argv[3]);
-	PAGE_SIZE = atoi(argv[4]);
-	NUMBER_OF_PAGES = atoll(argv[5]);
+	SimConfig config(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]), atoi(argv[4]), atoll(argv[5]));
 	WindowSizeFlag window_size_flag = windowSizeFlagToEnum(argv[6]);
 	if (window_size_flag == INVALID_WINDOW_SIZE_FLAG){
 		cerr << "Invalid Window Size Flag Parameter!" << endl;
@@ -79,33 +487,110 @@ int main(int argc, char** argv) {
         printHelp();
         return -1;
 	}
+	if ((page_dist == TRACE) != (flags.trace.path != nullptr)){
+        cerr << "The trace distribution must be used with --trace=trace_file!" << endl;
+        printHelp();
+        return -1;
+	}
+	if ((page_dist == TIERED) != !flags.skew.tiers.empty()){
+        cerr << "The tiers distribution must be used with --tiers=list!" << endl;
+        printHelp();
+        return -1;
+	}
 	Algorithm algo = algoStringToEnum(argv[8]);
 	if (algo == INVALID_ALGO){
         cerr << "Invalid Algorithm Parameter!" << endl;
         printHelp();
         return -1;
 	}
+	if (flags.stream_chunk && algo == WRITING_ASSIGNMENT && !flags.record_file){
+        cerr << "Streaming (and pipelining) is not supported by the writing assignment algorithm!" << endl;
+        printHelp();
+        return -1;
+	}
+	if ((flags.checkpoint || flags.telemetry.path) && algo == WRITING_ASSIGNMENT && !flags.record_file){
+        cerr << "Checkpoints and telemetry are not supported by the writing assignment algorithm!" << endl;
+        printHelp();
+        return -1;
+	}
+
+	/* a resumed simulation must start from the random state of its checkpoint */
+	if (flags.resume && !flags.seeded && !flags.record_file && access(flags.checkpoint, F_OK) == 0) {
+		CheckpointReader checkpoint(flags.checkpoint);
+		if (checkpoint.header().flags & CHECKPOINT_HAS_SEED) {
+			flags.seeded = true;
+			flags.seed = checkpoint.header().seed;
+		}
+	}
+
+    /* activate random number generator seed */
+    RandomGenerator rng;
+	if (flags.seeded){
+		rng.seed(flags.seed);
+	}
+	else {
+		flags.seed = rng.seed();
+	}
+
+	if (flags.record_file){
+		/* the sequence is streamed into the file, so it is never kept in memory as a whole. the window flag and
+		 * the algorithm are not used
+		 */
+		AlgoRunner* recorder = new AlgoRunner(config, rng, page_dist, GREEDY, WINDOW_SIZE_OFF, NO_PAYLOAD,
+		                                      flags.stream_chunk ? flags.stream_chunk : DEFAULT_STREAM_CHUNK, flags.trace,
+		                                      flags.threads ? flags.threads : 1, flags.skew);
+		if (flags.pipeline){
+			recorder->setPipelined();
+		}
+		unsigned long long file_size = recorder->recordWritingSequence(flags.record_file, flags.seed);
+		cout << "Recorded " << recorder->config.number_of_pages << " page writes to " << flags.record_file << " ("
+		     << file_size << " bytes, seed " << flags.seed << ")." << endl;
+		delete recorder;
+		if (argc == 10){
+			fclose(stdout);
+		}
+		return 0;
+	}
 
-	float ALPHA = (float) LOGICAL_BLOCK_NUMBER / PHYSICAL_BLOCK_NUMBER;
+	float ALPHA = (float) config.logical_blocks / config.physical_blocks;
     cout << "Starting GC Simulator!" << endl;
-	cout << "Physical Blocks:\t" << PHYSICAL_BLOCK_NUMBER << endl;
-	cout << "Logical Blocks:\t\t" << LOGICAL_BLOCK_NUMBER << endl;
-	cout << "Pages/Block:\t\t" << PAGES_PER_BLOCK << endl;
-	cout << "Page Size:\t\t" << PAGE_SIZE << endl;
+	cout << "Physical Blocks:\t" << config.physical_blocks << endl;
+	cout << "Logical Blocks:\t\t" << config.logical_blocks << endl;
+	cout << "Pages/Block:\t\t" << config.pages_per_block << endl;
+	cout << "Page Size:\t\t" << config.page_size << endl;
 	cout << "Alpha:\t\t\t" << ALPHA << endl;
-	cout << "Over Provisioning:\t"<< (float)(PHYSICAL_BLOCK_NUMBER-LOGICAL_BLOCK_NUMBER)/LOGICAL_BLOCK_NUMBER<<endl;
-    cout << "Number of Pages:\t" << NUMBER_OF_PAGES << endl;
+	cout << "Over Provisioning:\t"<< (float)(config.physical_blocks-config.logical_blocks)/config.logical_blocks<<endl;
+    cout << "Number of Pages:\t" << config.number_of_pages << endl;
     cout << "Page Distribution:\t" << argv[7] << endl;
+    if (page_dist == ZIPF || page_dist == YCSB) {
+        cout << "Zipf Theta:\t\t" << flags.skew.zipf_theta << endl;
+    }
+    if (page_dist == TIERED) {
+        cout << "Tiers:\t\t\t";
+        for (unsigned int i = 0; i < flags.skew.tiers.size(); i++) {
+            cout << (i ? ", " : "") << flags.skew.tiers[i].page_percentage << "% of the pages: "
+                 << flags.skew.tiers[i].probability;
+        }
+        cout << endl;
+    }
     cout << "GC Algorithm:\t\t" << argv[8] << endl;
+    cout << "Seed:\t\t\t" << flags.seed << endl;
     cout << endl;
 
 
 
-    /* activate random number generator seed */
-	seed();
-
 	/* generate scheduledGC object */
-    AlgoRunner* scg = new AlgoRunner(NUMBER_OF_PAGES, page_dist, algo, window_size_flag);
+    AlgoRunner* scg = new AlgoRunner(config, rng, page_dist, algo, window_size_flag, flags.payload_mode,
+                                     flags.stream_chunk, flags.trace, flags.threads ? flags.threads : 1, flags.skew);
+    scg->setCandidateSelection(flags.candidate_buckets, flags.candidate_budget);
+    scg->setWarmup(flags.warmup);
+    scg->setSteadyStateCheckpoint(flags.load_steady_state, flags.save_steady_state, true, flags.seed);
+    scg->setRunCheckpoint(flags.checkpoint, flags.checkpoint_interval, flags.resume);
+    scg->setTelemetry(flags.telemetry);
+    scg->setProfiling(flags.report_file != nullptr);
+    if (flags.pipeline){
+        scg->setPipelined();
+    }
 
     /* if you wish to activate print mode remove comment */
     //scg->setPrintMode(true);
@@ -116,6 +601,9 @@ int main(int argc, char** argv) {
     /* run simulation and print results */
     scg->runSimulation(algo);
     scg->printSimulationResults();
+    if (flags.report_file){
+        scg->writeReport(flags.report_file, argv[7], argv[8], flags.seed);
+    }
 
     /* cleanup */
     delete scg;
@@ -5,14 +5,9 @@
 
 #define OVER_LOADING_FACTOR 15.3792
 
-int PHYSICAL_BLOCK_NUMBER, LOGICAL_BLOCK_NUMBER, PAGES_PER_BLOCK, PAGE_SIZE;
-unsigned long long NUMBER_OF_PAGES;
-/* PHYSICAL_BLOCK_NUMBER - number of physical blocks
- * LOGICAL_BLOCK_NUMBER - number of logical blocks
- * PAGES_PER_BLOCK - number of pages per block
- * PAGE_SIZE - number of bytes per page
- */
+/* the memory geometry of a simulation is kept in its SimConfig (see SimConfig.h) */
 
+/* stdout redirection to the output file (process wide) */
 int fd_stdout = dup(1);
 char* output_file = nullptr;
 